@@ -41,16 +41,26 @@
 #define DEFAULT_DECAY_RELEASE 0.95                 // Fits to ARRAY_SIZE 1024
 #define DEFAULT_ADR_uS 300000                       // Default Attack, Decay and Release in us
 #define DEFAULT_SUSTAIN_LEVEL 0.5                   // Relative to max sustain
+#define DEFAULT_DAC_SIZE 4096                       // 12 bit DAC
 
 #include <pico/stdlib.h>
 
 class ADSR {
 public:
 
+    // Settings, held by the ADSR itself or, once bound, in a parameter set elsewhere (see ADSRBank scenes)
+    struct Params {
+        uint64_t attack = 0;
+        uint64_t decay = 0;
+        int sustain = 0;
+        uint64_t release = 0;
+        bool reset_attack = false;
+    };
+
     // Constructor
     // Max value of the DAC = 2^resolution. E.g. for a 12bit DAC -> 4096
     ADSR(
-        int dac_size,
+        int dac_size = DEFAULT_DAC_SIZE,
         float attack_alpha = DEFAULT_ATTACK_ALPHA,
         float attack_decay_release = DEFAULT_DECAY_RELEASE
     );
@@ -68,25 +78,48 @@ public:
     // Options
     void set_reset_attack(bool l_reset_attack);   // if _reset_attack is true a new trigger starts with 0,
                                                 // if _reset_attack is false it starts with the current output value
+    bool get_reset_attack();
+
+    // Read settings from (*play_set)[index] and write the setters to (*edit_set)[index] instead of
+    // the ADSR's own. Changing what the pointers point at switches every bound channel at once.
+    void bind_params(Params *const *play_set, Params *const *edit_set, int index);
+    const Params &get_params() const { return _play_params(); }
 
     bool is_on();
+    bool is_steady(uint64_t now) const;           // output holds still from this time on: at the sustain level, or released to 0
 
     // Output
     int envelope();
+    int envelope(uint64_t now);                   // output at a given time in µs since boot, for rendering ahead
 
 private:
-    int _attack_table[LUT_SIZE];
-    int _decay_release_table[LUT_SIZE];
+    // Look-up tables are shared between all instances built with the same resolution and curves,
+    // so adding channels doesn't add table memory
+    struct Tables {
+        int vertical_resolution;
+        float attack_alpha;
+        float attack_decay_release;
+        uint16_t attack[LUT_SIZE];
+        uint16_t decay_release[LUT_SIZE];
+        Tables *next;
+    };
+    static Tables *_tables;
+    static const Tables *_get_tables(int vertical_resolution, float attack_alpha, float attack_decay_release);
+
+    const uint16_t *_attack_table;
+    const uint16_t *_decay_release_table;
 
     float _attach_alpha;
     float _attack_decay_release;
 
     int _vertical_resolution;                   // number of bits for output, control, etc
-    uint64_t _attack = 0;
-    uint64_t _decay = 0;
-    int _sustain = 0;
-    uint64_t _release = 0;
-    bool _reset_attack = false;
+    Params _params;
+    Params *const *_play_set = nullptr;
+    Params *const *_edit_set = nullptr;
+    int _set_index = 0;
+
+    const Params &_play_params() const { return _play_set ? (*_play_set)[_set_index] : _params; }
+    Params &_edit_params() { return _edit_set ? (*_edit_set)[_set_index] : _params; }
 
     // Time stamp for note on and note off
     uint64_t _t_note_on = 0;
@@ -98,10 +131,21 @@ private:
     int _attack_start;
     int _notes_pressed = 0;
 
+    int _value_at(uint64_t now) const;
+
     static inline long _map(long x, long in_min, long in_max, long out_min, long out_max) {
         return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
     }
 
+    // µs from since to now in 32 bits, as the RP2040 has always done the envelope maths. Held at
+    // the maximum rather than wrapping, so a gate held past 71 minutes doesn't start a new attack.
+    static inline uint32_t _elapsed(uint64_t now, uint64_t since) {
+        if (now <= since) {
+            return 0;
+        }
+        return (now - since > UINT32_MAX) ? UINT32_MAX : (uint32_t)(now - since);
+    }
+
     static inline uint64_t _micros() {
         return to_us_since_boot(get_absolute_time());
     }
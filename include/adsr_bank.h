@@ -0,0 +1,103 @@
+/**
+ * ADSRBank class
+ *
+ * A fixed size set of ADSR channels. The channel count is a compile-time
+ * parameter so the same engine builds 4, 8 or 16 channel modules, and all
+ * channels share one set of look-up tables (see ADSR).
+ *
+ * The channels' settings live in the bank as SCENES parameter sets. One
+ * scene plays, and the channel setters write to the scene being edited,
+ * which may be another one. play_scene() switches every channel with one
+ * pointer store, so called between two renders no frame mixes scenes.
+ *
+ * ```
+ * ADSRBank<8> bank;
+ *
+ * bank[2].note_on();
+ * for (int ch = 0; ch < bank.size(); ch++) {
+ *      output(ch, bank[ch].envelope());
+ * }
+ * ```
+ * */
+
+#ifndef _PICO_LIB_ADSR_BANK_H
+#define _PICO_LIB_ADSR_BANK_H
+
+#include "adsr.h"
+
+template <int N, int SCENES = 1>
+class ADSRBank {
+public:
+    static_assert(N > 0, "ADSRBank needs at least one channel");
+    static_assert(SCENES > 0, "ADSRBank needs at least one scene");
+
+    ADSRBank() {
+        for (int ch = 0; ch < N; ch++) {
+            for (int scene = 0; scene < SCENES; scene++) {
+                _scenes[scene][ch] = _channels[ch].get_params();
+            }
+            _channels[ch].bind_params(&_play, &_edit, ch);
+        }
+    }
+
+    ADSR &operator[](int channel) { return _channels[channel]; }
+    const ADSR &operator[](int channel) const { return _channels[channel]; }
+
+    static constexpr int size() { return N; }
+    static constexpr int scenes() { return SCENES; }
+
+    // O(1) whatever N is. Call on the rendering core between frames.
+    void play_scene(int scene) {
+        _play = _scenes[scene];
+        _play_index = scene;
+    }
+    int playing_scene() const { return _play_index; }
+
+    // Where the channel setters write
+    void edit_scene(int scene) {
+        _edit = _scenes[scene];
+        _edit_index = scene;
+    }
+    int editing_scene() const { return _edit_index; }
+
+    const ADSR::Params &scene_params(int scene, int channel) const { return _scenes[scene][channel]; }
+    void copy_scene(int from, int to) {
+        for (int ch = 0; ch < N; ch++) {
+            _scenes[to][ch] = _scenes[from][ch];
+        }
+    }
+
+    // Evaluate every channel, out must hold N values
+    void render(int *out) {
+        for (int ch = 0; ch < N; ch++) {
+            out[ch] = _channels[ch].envelope();
+        }
+    }
+
+    // Evaluate every channel at a given time in µs since boot
+    void render(int *out, uint64_t now) {
+        for (int ch = 0; ch < N; ch++) {
+            out[ch] = _channels[ch].envelope(now);
+        }
+    }
+
+    // True when no channel's output is moving at this time
+    bool is_steady(uint64_t now) const {
+        for (int ch = 0; ch < N; ch++) {
+            if (!_channels[ch].is_steady(now)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    ADSR _channels[N];
+    ADSR::Params _scenes[SCENES][N];
+    ADSR::Params *_play = _scenes[0];
+    ADSR::Params *_edit = _scenes[0];
+    int _play_index = 0;
+    int _edit_index = 0;
+};
+
+#endif
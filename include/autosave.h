@@ -0,0 +1,42 @@
+/**
+ * Write-behind autosave of the panel settings
+ *
+ * Every channel's settings are saved AUTOSAVE_DELAY_MS after the last
+ * edit, so turning a knob costs one write for the whole gesture, and
+ * restored at boot.
+ *
+ * The saves go to an append-only log of fixed-size records, each with a
+ * sequence number and a CRC, over AUTOSAVE_SEGMENTS files of up to one
+ * LittleFS block each. When a segment is full the next one is started
+ * from empty. At boot the newest valid record wins. A record cut short by
+ * a power cut fails its CRC and the one before it is used.
+ *
+ * The segments bound how much a restore reads, they don't save erases.
+ * LittleFS is copy on write: an append copies the file's partly filled
+ * last block to a newly erased block and commits the metadata, so every
+ * record costs at least one erase, and where the wear lands is LittleFS's
+ * block allocation. printAutosave() reports the erases and page programs
+ * the appends actually caused, counted at the flash driver (flash_safe.h).
+ *
+ * Each append is one flash_safe.h step.
+ * */
+
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <Arduino.h>
+
+#define AUTOSAVE_DELAY_MS 3000       // Quiet time after the last edit before saving
+#define AUTOSAVE_SEGMENTS 4
+#define AUTOSAVE_SEGMENT_BYTES 4096  // One LittleFS block
+
+extern uint32_t autosaveWrites;   // Records appended since boot
+extern uint32_t autosaveSectorsErased;   // Flash sectors those appends erased
+extern uint32_t autosavePagesProgrammed; // Flash pages they programmed
+extern uint32_t autosaveSkipped;  // Saves not needed, the settings were edited back to what was stored
+
+void restoreAutosave(); // Boot, after setupEncoderRead() and LittleFS.begin()
+void autosaveService(); // From loop()
+void printAutosave();
+
+#endif
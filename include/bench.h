@@ -0,0 +1,40 @@
+/**
+ * Hot path microbenchmarks
+ *
+ * Times single calls of the functions that run every frame or every
+ * pass of loop(), each in the states that take different paths: the
+ * envelope in each phase, the DAC cache and write with nothing, one or
+ * every channel changed, readEncoder() idle and moving, and oledUpdate()
+ * not due, due with nothing to draw, and redrawing.
+ *
+ * Times are rp2040.getCycleCount(): SysTick on the RP2040, the host's
+ * monotonic clock scaled to F_CPU on the native build. The cost of
+ * reading the counter is measured first and taken off every run.
+ *
+ * Results are CSV, one row per case, so runs can be diffed or loaded
+ * into a spreadsheet:
+ *
+ * ```
+ * # bench timer=systick f_cpu=133000000 channels=4 dac=MCP4922
+ * bench,function,case,runs,min_cycles,median_cycles,max_cycles,median_ns
+ * bench,envelope,attack,128,...
+ * ```
+ *
+ * The DAC cases run with core1 parked between frames (flash_safe.h), so
+ * they own the DAC state, and the outputs catch up on the next frame.
+ * The moving readEncoder() case turns the selected channel's decay back
+ * and forth and then puts it back. The oledUpdate() cases wait out the
+ * display's refresh interval between runs, so they take about 2s.
+ * */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+
+#define BENCH_RUNS 128     // Runs per case
+#define BENCH_OLED_RUNS 16 // Runs per oledUpdate() case that needs a frame due
+
+void runBenchmarks(); // Core0, prints the results
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * Startup order and boot timing
+ *
+ * setup() only starts what the outputs need to follow the gates: the gate
+ * and button inputs, and the channel defaults. Core1 brings the DAC up in
+ * setup1() in parallel. Everything else is a step of bootService(), run
+ * one per loop() pass with the gates polled in between: filesystem and
+ * calibration, the autosaved state, encoders, display. Encoder phase
+ * calibration carries on in the background from encoderUpdate().
+ *
+ * Core1 is sending frames by the time the filesystem steps run, so they
+ * only read: the mount, the calibration, the preset directory listing and
+ * the autosave log. Nothing in boot waits on the outputs. The writes boot
+ * finds it needs are left pending for the services in loop(), which make
+ * them as flash safe steps like any other write: formatting a filesystem
+ * that won't mount (bootFilesystemService()), removing a preset save cut
+ * short (presetService()). Directories are made by the first write into
+ * them.
+ *
+ * Each phase records when it finished, in µs since power-on.
+ * */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+enum BootPhase
+{
+  BOOT_SETUP,        // setup() entered, static constructors (envelope tables) done
+  BOOT_GATES_LIVE,   // Gate inputs polled
+  BOOT_OUTPUT_READY, // Core1 has the DAC driver and output timer running
+  BOOT_FIRST_FRAME,  // First frame sent to the DACs
+  BOOT_FILESYSTEM,   // LittleFS mounted, DAC calibration loaded
+  BOOT_RESTORED,     // Autosaved state applied
+  BOOT_ENCODERS,     // Encoder state machines running
+  BOOT_DISPLAY,      // First frame on the panel and the panel switched on
+  BOOT_CALIBRATED,   // Encoder 1 phase calibration finished
+  BOOT_PHASES
+};
+
+extern volatile uint32_t bootTimeUs[BOOT_PHASES]; // time_us_32() when each phase was reached, 0 until then
+
+// Records the first time only, so it can sit on a path that runs repeatedly
+static inline void bootMark(BootPhase phase)
+{
+  if (bootTimeUs[phase] == 0)
+  {
+    bootTimeUs[phase] = max(1UL, (unsigned long)time_us_32());
+  }
+}
+
+bool bootService(); // Runs the next deferred startup step, true once there are none left
+void bootFilesystemService(); // From loop() after boot, formats a filesystem that wouldn't mount
+bool bootComplete();
+void printBootProfile();
+
+#endif
@@ -13,7 +13,9 @@ void setupButtons();
 void buttonsUpdate();
 bool checkEncoderButton(int encoderIndex);
 void encoder_button_pressed(int encoderIndex);
-void encoderDoublePressCheck();
+int buttonChannel(int encoderIndex);
+void selectChannel(int channel);
+bool encoderDoublePressCheck(); // True when the press switched scenes
 
 // Shared variables
 extern volatile ButtonState buttonState[4];
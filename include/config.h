@@ -5,15 +5,28 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <adsr.h>
+#include "adsr_bank.h"
 
 // Constants
 #define DEBOUNCE_TIME 35 // Encoder switch debounce time
 
+// Number of envelope channels. The four encoders and buttons work on one page of 4 channels at a time.
+#ifndef NUM_CHANNELS
+#define NUM_CHANNELS 4
+#endif
+static_assert(NUM_CHANNELS % 4 == 0 && NUM_CHANNELS <= 16, "NUM_CHANNELS must be 4, 8, 12 or 16");
+#define NUM_PAGES (NUM_CHANNELS / 4)
+
+// In-RAM scenes of every channel's settings, switched instantly (scenes.h)
+#ifndef NUM_SCENES
+#define NUM_SCENES 2
+#endif
+
 // Public variables
-extern unsigned long adsr_attack[4];            // time in µs
-extern unsigned long adsr_decay[4];             // time in µs
-extern int           adsr_sustain[4];                       // sustain level -> from 0 to DACSIZE-1
-extern unsigned long adsr_release[4];         // time in µs
+extern unsigned long adsr_attack[NUM_CHANNELS];            // time in µs
+extern unsigned long adsr_decay[NUM_CHANNELS];             // time in µs
+extern int           adsr_sustain[NUM_CHANNELS];                       // sustain level -> from 0 to DACSIZE-1
+extern unsigned long adsr_release[NUM_CHANNELS];         // time in µs
 
 extern const long long adsr_attack_max;            // time in µs
 extern const long long adsr_decay_max;             // time in µs
@@ -23,17 +36,21 @@ extern const long long adsr_release_max;         // time in µs
 extern unsigned long trigger_duration;       // time in µs
 extern unsigned long space_between_triggers; // time in µs
 
-extern ADSR adsr_class[4];                      // ADSR class instances, one per channel
+extern ADSRBank<NUM_CHANNELS, NUM_SCENES> adsr_class; // ADSR class instances, one per channel
 
-extern bool oledUpdateNeeded;            // Flag to indicate if an update is needed
+extern uint32_t paramsVersion;           // Bumped whenever an ADSR parameter changes, so the display knows to redraw
+extern uint32_t uiVersion;               // Bumped whenever the screen state changes
 
-extern int channel_selected;                    // currently selected channel (0-3)
+extern int channel_selected;                    // currently selected channel (1-NUM_CHANNELS)
+extern int channel_page;                        // page of 4 channels the buttons select from (0-NUM_PAGES-1)
 
 // Screen states
 enum State
 {
   ADSR_SCREEN,
   MENU_SCREEN,
+  SCOPE_SCREEN,
+  MORPH_SCREEN,
 };
 extern State currentState;
 
@@ -58,6 +75,26 @@ const int encoder4_pinB = 11;
 //DACs
 const int DAC_CS_PIN = 22; // Chip Select pin for first DAC
 const int DAC_CS_PIN2 = 27; // Chip Select pin for second DAC
+const int DAC_SCK_PIN = 18; // SPI clock, shared by both DACs
+const int DAC_MOSI_PIN = 19; // SPI data, shared by both DACs (must be DAC_SCK_PIN + 1 for PIO output)
+const int DAC_LDAC_PIN = 26; // LDAC, shared by all DACs, within 8 pins of the chip selects. -1 if LDAC is tied to ground
+
+// MCP23S17 expander on the DAC SPI bus, its outputs are the chip selects for DACs 3 and up
+const int EXPANDER_CS_PIN = 28;
+const int EXPANDER_PIN_BASE = 100; // DAC_CS_MAP values from here up are expander pins, GPA0-7 then GPB0-7
+
+// Chip select for each MCP4922, one per two channels
+const int DAC_CS_MAP[8] = {DAC_CS_PIN, DAC_CS_PIN2,
+                           EXPANDER_PIN_BASE + 0, EXPANDER_PIN_BASE + 1, EXPANDER_PIN_BASE + 2,
+                           EXPANDER_PIN_BASE + 3, EXPANDER_PIN_BASE + 4, EXPANDER_PIN_BASE + 5};
+
+// MCP4728 DAC on Wire1 (DAC_DRIVER_MCP4728 builds only, replaces the MCP4922s)
+const int MCP4728_SDA_PIN = 26;
+const int MCP4728_SCL_PIN = 27;
+
+// PWM outputs (DAC_DRIVER_PWM builds only). Each pin needs a slice and channel of its own,
+// GPIO n is slice (n / 2) % 8, channel A for even n and B for odd: 6A, 6B, 5A, 5B
+constexpr int PWM_OUT_PINS[4] = {12, 13, 26, 27};
 
 // Encoder button pins
 const int BUTTON_1_PIN = 6;
@@ -71,4 +108,7 @@ const int GATE_2_PIN = 1;
 const int GATE_3_PIN = 2;
 const int GATE_4_PIN = 3;
 
+// With more channels than gate inputs, channel n follows gate (n % 4) + 1
+const int NUM_GATES = 4;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+// CRC-32 as used by zlib and PNG. Pass the previous result as crc to continue over several buffers.
+uint32_t crc32(const void *data, size_t length, uint32_t crc = 0);
+
+#endif
@@ -4,13 +4,63 @@
 
 #include <Arduino.h>
 #include <SPI.h>
+#include "dac_driver.h"
+#include "config.h"
+
+// MCP4922 driver only:
+// 1 = PIO + DMA output (CS, clock and data driven by a PIO state machine)
+// 0 = blocking output through the SPI library
+#ifndef DAC_PIO_OUTPUT
+#define DAC_PIO_OUTPUT 1
+#endif
+
+// Longest time a channel goes without being rewritten, even when its value hasn't changed
+#ifndef DAC_REFRESH_INTERVAL_US
+#define DAC_REFRESH_INTERVAL_US 20000
+#endif
+
+// 1 = load every channel, then update all outputs together (LDAC pulse on the MCP4922)
+// 0 = each output updates as soon as its channel is written
+#ifndef DAC_LATCHED_OUTPUT
+#define DAC_LATCHED_OUTPUT 0
+#endif
+
+// Calibration correction points, 17 per channel covering codes 0 to 4096
+#define DAC_CAL_SHIFT 8
+#define DAC_CAL_POINTS ((4096 >> DAC_CAL_SHIFT) + 1)
+
+extern int16_t dacCalibration[NUM_CHANNELS][DAC_CAL_POINTS]; // Corrected output code at each point, per channel
+
+extern DacDriver *dacDriver;  // Output backend, see dac_driver.h
+extern uint32_t dacSamplePeriodUs; // Engine sample period that fits the driver's frame time, the FIFO may raise it
 
 extern bool dacUpdateNeeded; // Flag to indicate if DAC update is needed
+extern uint32_t dacRefreshIntervalUs; // Forced refresh interval, defaults to DAC_REFRESH_INTERVAL_US
+extern volatile uint32_t dacFramesPerSecond; // dacWrite() calls in the last second
+extern volatile uint32_t dacWritesIssued;    // Channel writes sent to the DACs
+extern volatile uint32_t dacWritesSkipped;   // Channel writes skipped because the value hadn't changed
+extern volatile uint32_t dacFrameGapMaxUs;      // Longest time between frames, core0 may reset it
+extern volatile uint32_t dacFrameGapMovedMaxUs; // Longest time between frames where the output had moved
+
+// Inter-channel skew, [0] immediate and [1] latched output, measured on core1 by requestDacSkewMeasurement()
+extern volatile bool dacLatchedOutput;       // Output mode, core1 applies changes between frames
+extern volatile uint32_t dacSkewNs[2];       // Spread between the first and last channel update
+extern volatile uint32_t dacLatencyNs[2];    // Frame start to the last channel update
+extern volatile bool dacSkewMeasured[2];
 
 // Function declarations
 void setupDAC();
 void dacWrite();
-void cacheDacValue(int channel, float voltage);
+void dacWriteFrame(const uint16_t *values);
+void dacApplyPending(); // Calibration, output mode and skew requests, core1 between frames
+int calibrateDacValue(int channel, int value);
+void cacheDacValue(int channel, int value);
+void setDacCalibrationLinear(int channel, float gain, float offset);
+bool loadDacCalibration();
+bool saveDacCalibration();
 void printDacValues();
+void printDacFrameRate();
+void requestDacSkewMeasurement();
+void printDacSkew();
 
 #endif
@@ -0,0 +1,117 @@
+/**
+ * DAC drivers
+ *
+ * dac.cpp does the calibration and change tracking, then hands the final
+ * 12 bit codes for all channels to one of these backends as a single frame.
+ *
+ * Select the backend at build time with DAC_DRIVER:
+ *   DAC_DRIVER_MCP4922  two MCP4922 over SPI, PIO + DMA with a blocking SPI fallback (default)
+ *   DAC_DRIVER_MCP4728  one MCP4728 using the I2C fast write, all 4 channels in one transfer
+ *   DAC_DRIVER_PWM      RP2040 PWM outputs, needs an RC filter on each pin
+ *   DAC_DRIVER_MOCK     records frames in RAM, for host tests
+ * */
+
+#ifndef DAC_DRIVER_H
+#define DAC_DRIVER_H
+
+#include <Arduino.h>
+
+#define DAC_DRIVER_MCP4922 0
+#define DAC_DRIVER_MCP4728 1
+#define DAC_DRIVER_PWM 2
+#define DAC_DRIVER_MOCK 3
+
+#ifndef DAC_DRIVER
+#define DAC_DRIVER DAC_DRIVER_MCP4922
+#endif
+
+#define DAC_ALL_CHANNELS 0xFFFFFFFF
+
+class DacDriver {
+public:
+    virtual ~DacDriver() {}
+
+    virtual bool begin() = 0;
+
+    // Write n channels in one batch. Bit i of channel_mask is set if values[i] needs sending,
+    // backends that always send every channel ignore it.
+    virtual void write_frame(const uint16_t *values, int n, uint32_t channel_mask = DAC_ALL_CHANNELS) = 0;
+
+    virtual const char *name() const = 0;
+
+    // Measured time for a full frame on the bus in µs, so the engine can set its sample rate to fit
+    uint32_t frame_time_us() const { return _frame_time_us; }
+
+    // Latched output loads every channel first, then updates them all together.
+    // Returns false if the backend can't latch.
+    virtual bool set_latched(bool latched) { return !latched; }
+    bool latched() const { return _latched; }
+
+    // Write a full frame and time when each channel's output changed, in CPU cycles from the start
+    // of the frame. Returns the number of channels timed, 0 if the backend can't measure it.
+    virtual int measure_update_cycles(const uint16_t *values, int n, uint32_t *cycles) { return 0; }
+
+protected:
+    uint32_t _frame_time_us = 0;
+    bool _latched = false;
+};
+
+// MCP4922s sharing SCK and MOSI. Chip selects come from DAC_CS_MAP, either a GPIO
+// or an MCP23S17 output on the same bus for more than two DACs.
+class MCP4922Driver : public DacDriver {
+public:
+    bool begin() override;
+    void write_frame(const uint16_t *values, int n, uint32_t channel_mask = DAC_ALL_CHANNELS) override;
+    const char *name() const override { return _use_pio ? "MCP4922 PIO" : "MCP4922 SPI"; }
+    bool set_latched(bool latched) override;
+    int measure_update_cycles(const uint16_t *values, int n, uint32_t *cycles) override;
+
+private:
+    bool _begin_pio();
+    void _send(int count);
+    void _send_pio(int count);
+    void _send_spi(int count);
+    void _time_pio(int count);
+
+    bool _use_pio = false;
+};
+
+// MCP4728 quad DAC, fast write updates all four channels in one I2C transfer. Channels past 4 are dropped.
+class MCP4728Driver : public DacDriver {
+public:
+    bool begin() override;
+    void write_frame(const uint16_t *values, int n, uint32_t channel_mask = DAC_ALL_CHANNELS) override;
+    const char *name() const override { return "MCP4728"; }
+};
+
+// RP2040 PWM at 12 bit resolution, fallback when no DAC is fitted. One pin per channel in PWM_OUT_PINS.
+class PWMDacDriver : public DacDriver {
+public:
+    bool begin() override;
+    void write_frame(const uint16_t *values, int n, uint32_t channel_mask = DAC_ALL_CHANNELS) override;
+    const char *name() const override { return "PWM"; }
+};
+
+// Keeps the most recent frames in a ring, for host tests
+#define DAC_MOCK_FRAMES 256
+#define DAC_MOCK_CHANNELS 16
+
+class MockDacDriver : public DacDriver {
+public:
+    bool begin() override;
+    void write_frame(const uint16_t *values, int n, uint32_t channel_mask = DAC_ALL_CHANNELS) override;
+    const char *name() const override { return "Mock"; }
+
+    void set_frame_time_us(uint32_t frame_time_us) { _frame_time_us = frame_time_us; }
+    uint32_t frame_count() const { return _frame_count; }
+    // Frame written `age` frames ago, 0 is the most recent
+    const uint16_t *frame(uint32_t age) const { return _frames[(_frame_count - 1 - age) % DAC_MOCK_FRAMES]; }
+    uint32_t channel_mask(uint32_t age) const { return _masks[(_frame_count - 1 - age) % DAC_MOCK_FRAMES]; }
+
+private:
+    uint16_t _frames[DAC_MOCK_FRAMES][DAC_MOCK_CHANNELS];
+    uint32_t _masks[DAC_MOCK_FRAMES];
+    uint32_t _frame_count = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * DAC output FIFO
+ *
+ * Core1 renders envelope frames ahead of time into a short ring, and a
+ * repeating timer on core1 sends one frame to the DAC driver every
+ * dacFifoPeriodUs: the driver's frame time, raised to fit a render and
+ * the interrupt, and never below DAC_FIFO_MIN_PERIOD_US. A slow render
+ * no longer delays the next DAC frame, it only eats into the frames
+ * already queued.
+ *
+ * That minimum caps FIFO builds at 10000 frames/s (100 us) by default,
+ * however short the driver's frame time: the PWM driver and the MCP4922
+ * could go faster in lockstep (DAC_FIFO_DEPTH 0). Set
+ * DAC_FIFO_MIN_PERIOD_US lower to trade core1 time for rate.
+ *
+ * Gate changes call dacFifoInvalidate(), which drops every queued frame
+ * so the next frame out is rendered after the trigger. Parameter changes
+ * from the encoders are not flushed and reach the output after the
+ * queued frames.
+ * */
+
+#ifndef DAC_FIFO_H
+#define DAC_FIFO_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Frames rendered ahead of the output. 0 renders and writes in lockstep in loop1(),
+// with no rate cap; above 0 the output runs at most 1000000 / DAC_FIFO_MIN_PERIOD_US frames/s.
+#ifndef DAC_FIFO_DEPTH
+#define DAC_FIFO_DEPTH 4
+#endif
+
+// Shortest output timer period, so the highest FIFO frame rate (100 us: 10 kHz). Every tick
+// interrupts core1 whether or not a channel changed, so a driver with a faster frame time
+// still runs the engine at this rate.
+#ifndef DAC_FIFO_MIN_PERIOD_US
+#define DAC_FIFO_MIN_PERIOD_US 100
+#endif
+
+// Alarm pool interrupt entry, rescheduling and exit, added to the measured frame cost
+#define DAC_FIFO_IRQ_US 4
+
+extern volatile int dacFifoDepth;                // Frames in use, 1 to DAC_FIFO_DEPTH
+extern volatile uint32_t dacFifoUnderruns;       // Timer ticks with no frame ready
+extern volatile uint32_t dacFifoFlushes;         // Gate changes that dropped queued frames
+extern volatile uint32_t dacFifoQueueLatencyUs;  // Smoothed render to output time
+extern volatile uint32_t dacFifoTriggerLatencyUs; // Gate change to the first frame rendered after it
+extern volatile uint32_t dacFifoWriteCycles;     // Smoothed timer handler cost, CPU cycles
+
+// Core1
+void setupDacFifo();
+bool dacFifoService(); // Renders the next frame if there is room, returns false when the FIFO is full
+void dacFifoHold(bool hold); // Stop and restart the output timer, for flash writes (flash_safe.h)
+
+// Core0
+void dacFifoInvalidate();
+void printDacFifo();
+void runDacFifoBenchmark();
+
+#endif
@@ -7,11 +7,16 @@
 extern volatile bool arrayNewTargetValue; 
 extern int direction;
 //extern int lastDirection;
+extern volatile uint32_t readEncoderIdleCycles;   // Smoothed cost of a call with no movement, in CPU cycles
+extern volatile uint32_t readEncoderMovingCycles; // Smoothed cost of a call that applied a change, in CPU cycles
 
 // Function declarations
 void setupEncoderRead();
 int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int channel);
 void setTargetValue(int newTargetValue, int parameter);
 int getTargetValue(int parameter, int channel);
+void setChannelParameters(int channel, int attackStep, int decayStep, int sustain, int releaseStep);
+void setChannelParameter(int channel, int parameter, int value);
+void printReadEncoderCost();
 
 #endif // encoder_read_H
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * Factory envelope shapes
+ *
+ * Ready-made settings for one channel, picked from the menu. The table is
+ * constexpr: written in µs and levels, converted to encoder steps by the
+ * compiler against the log-time tables, and read straight from flash.
+ * Entry 0 is the power-on default for every channel.
+ * */
+
+#ifndef FACTORY_PRESETS_H
+#define FACTORY_PRESETS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "log_time.h"
+
+struct FactoryPreset
+{
+    const char *name;    // Menu label, at most 12 characters
+    int16_t attackStep;  // Encoder step on attackDecayTimeTable
+    int16_t decayStep;   // Encoder step on attackDecayTimeTable
+    int16_t sustain;     // Level, 0 to 4095
+    int16_t releaseStep; // Encoder step on releaseTimeTable
+};
+
+constexpr FactoryPreset factoryPreset(const char *name, uint32_t attackUs, uint32_t decayUs, int16_t sustain, uint32_t releaseUs)
+{
+    return {name,
+            (int16_t)logTimeToStep(attackDecayTimeTable, attackUs),
+            (int16_t)logTimeToStep(attackDecayTimeTable, decayUs),
+            sustain,
+            (int16_t)logTimeToStep(releaseTimeTable, releaseUs)};
+}
+
+inline constexpr FactoryPreset factoryPresets[] = {
+    //            name        attack    decay     sustain  release
+    factoryPreset("Init",     100000,   100000,   2500,    1000000),
+    factoryPreset("Perc",     1000,     180000,   0,       180000),
+    factoryPreset("Pluck",    2000,     450000,   600,     350000),
+    factoryPreset("Organ",    5000,     40000,    3700,    60000),
+    factoryPreset("Gate",     1000,     1000,     4095,    1000),
+    factoryPreset("Strings",  350000,   900000,   3300,    1500000),
+    factoryPreset("Pad",      1200000,  2000000,  3000,    4000000),
+    factoryPreset("Swell",    6000000,  3000000,  4095,    8000000),
+};
+constexpr int FACTORY_PRESETS = sizeof(factoryPresets) / sizeof(factoryPresets[0]);
+
+extern int factoryPresetSelected[NUM_CHANNELS]; // Shape last applied to each channel
+
+void applyFactoryPreset(int channel, int index); // Core0, one channel's times and level, 0-based channel
+
+#endif
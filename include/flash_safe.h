@@ -0,0 +1,59 @@
+/**
+ * Flash writes that don't disturb the outputs
+ *
+ * Erasing or programming flash stops XIP on both cores, and LittleFS
+ * idles core1 for each erase and program. Left to itself that lands
+ * anywhere, including mid-frame and mid-attack, and holds the outputs
+ * for as long as the flash takes (tens of ms for an erase).
+ *
+ * Flash work is done in small steps, one LittleFS operation each, from
+ * loop(). Each step:
+ *  - waits, without blocking, until flashSafeReady(): every channel's
+ *    output is steady (at the sustain level, or released to 0), so
+ *    holding the outputs changes nothing. While it waits the write stays
+ *    pending, and printFlashSafe() reports for how long. A patch that
+ *    never settles would hold a save off for good, so after
+ *    FLASH_SAFE_MAX_WAIT_MS the step runs anyway, still between two
+ *    frames, and is counted in flashSafeForced: the outputs that were
+ *    moving stand still for the length of the write. Steps keep going
+ *    ahead like this until the outputs settle, so a save's second step
+ *    doesn't wait again.
+ *  - runs between flashSafeBegin() and flashSafeEnd(), which park core1
+ *    between two frames in a RAM loop with the DAC timer stopped, so no
+ *    frame is cut short and core1 takes nothing from flash.
+ *
+ * A gate that arrives during a step is acted on when the step ends.
+ *
+ * Every sector erase and page program, LittleFS's included, is counted
+ * on its way to the SDK's flash functions ([env:pico] links them with
+ * --wrap), so callers can see what a step really cost the flash.
+ * */
+
+#ifndef FLASH_SAFE_H
+#define FLASH_SAFE_H
+
+#include <Arduino.h>
+
+#define FLASH_SAFE_MAX_WAIT_MS 30000    // Longest wait for steady outputs before a step runs regardless
+#define FLASH_SAFE_PARK_TIMEOUT_US 5000 // Core1 not answering (not started yet), go ahead without it
+
+extern uint32_t flashSafeLastParkUs; // Time core1 was parked for the last step
+extern uint32_t flashSafeMaxParkUs;  // Longest park since boot
+extern uint32_t flashSafeSteps;      // Steps run
+extern uint32_t flashSafeWaits;      // Steps that had to wait for the outputs to settle
+extern uint32_t flashSafeMaxWaitMs;  // Longest of those waits
+extern uint32_t flashSafeForced;     // Steps that ran while an output was moving, after FLASH_SAFE_MAX_WAIT_MS
+extern volatile uint32_t flashSectorsErased;   // 4 KB sectors erased since boot, 0 on the host
+extern volatile uint32_t flashPagesProgrammed; // 256 byte pages programmed since boot
+
+// Core0
+bool flashSafeReady(); // Call each pass until true, then run the step
+uint32_t flashSafeWaitingMs(); // How long the pending step has waited so far, 0 if none is waiting
+void flashSafeBegin(); // Returns once core1 is parked between frames
+void flashSafeEnd();
+void printFlashSafe();
+
+// Core1
+void flashSafePoll(); // Top of loop1(), parks here while core0 is writing
+
+#endif
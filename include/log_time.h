@@ -0,0 +1,115 @@
+/**
+ * Log-time tables for the attack, decay and release encoders
+ *
+ * Encoder step 0 to LOG_TIME_STEPS maps to a time on a log scale from
+ * LOG_TIME_MIN_US to the parameter's maximum, so each step is the same
+ * ratio of the time. The tables are computed by the compiler and live in
+ * flash, read through XIP, so nothing is built at boot and they take no
+ * RAM. Steps for fixed times (defaults, factory presets) are looked up at
+ * compile time as well.
+ * */
+
+#ifndef LOG_TIME_H
+#define LOG_TIME_H
+
+#include <Arduino.h>
+
+#define LOG_TIME_STEPS 1000
+#define LOG_TIME_MIN_US 1000
+#define ATTACK_DECAY_MAX_US 100000000 // 100 s
+#define RELEASE_MAX_US 1000000000     // 1000 s
+
+struct LogTimeTable
+{
+    uint32_t us[LOG_TIME_STEPS + 1]; // Index is the encoder step
+};
+
+// Natural log and exp for the compiler, the <cmath> ones aren't constexpr.
+// Both reduce the argument first so a short series is exact to double precision.
+constexpr double logTimeLn(double x)
+{
+    int exponent = 0;
+    while (x > 2)
+    {
+        x /= 2;
+        exponent++;
+    }
+    while (x < 1)
+    {
+        x *= 2;
+        exponent--;
+    }
+    // ln(x) = 2 atanh((x - 1) / (x + 1)), the ratio is at most 1/3 here
+    double y = (x - 1) / (x + 1);
+    double term = y;
+    double sum = 0;
+    for (int n = 1; n < 60; n += 2)
+    {
+        sum += term / n;
+        term *= y * y;
+    }
+    return 2 * sum + exponent * 0.69314718055994530942;
+}
+
+constexpr double logTimeExp(double x) // x >= 0
+{
+    int halvings = 0;
+    while (x > 0.5)
+    {
+        x /= 2;
+        halvings++;
+    }
+    double term = 1;
+    double sum = 1;
+    for (int n = 1; n < 24; n++)
+    {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0)
+    {
+        sum *= sum;
+    }
+    return sum;
+}
+
+constexpr LogTimeTable makeLogTimeTable(double minUs, double maxUs)
+{
+    LogTimeTable table = {};
+    double range = logTimeLn(maxUs / minUs);
+    for (int i = 0; i <= LOG_TIME_STEPS; i++)
+    {
+        table.us[i] = (uint32_t)(minUs * logTimeExp(range * i / LOG_TIME_STEPS) + 0.5);
+    }
+    return table;
+}
+
+inline constexpr LogTimeTable attackDecayTimeTable = makeLogTimeTable(LOG_TIME_MIN_US, ATTACK_DECAY_MAX_US); // Attack and Decay share the same range
+inline constexpr LogTimeTable releaseTimeTable = makeLogTimeTable(LOG_TIME_MIN_US, RELEASE_MAX_US);
+
+static_assert(attackDecayTimeTable.us[0] == LOG_TIME_MIN_US && attackDecayTimeTable.us[LOG_TIME_STEPS] == ATTACK_DECAY_MAX_US, "attack/decay table ends");
+static_assert(releaseTimeTable.us[0] == LOG_TIME_MIN_US && releaseTimeTable.us[LOG_TIME_STEPS] == RELEASE_MAX_US, "release table ends");
+
+// Encoder step -> time in µs
+constexpr uint32_t logTimeFromStep(const LogTimeTable &table, int step)
+{
+    return table.us[step < 0 ? 0 : (step > LOG_TIME_STEPS ? LOG_TIME_STEPS : step)];
+}
+
+// Time in µs -> encoder step, the highest step that doesn't exceed the time
+constexpr int logTimeToStep(const LogTimeTable &table, uint32_t us)
+{
+    int low = 0;
+    int high = LOG_TIME_STEPS;
+    while (low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if (table.us[mid] <= us)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+#endif
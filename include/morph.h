@@ -0,0 +1,36 @@
+/**
+ * Morph between two preset slots
+ *
+ * On the morph screen encoder 1 crossfades every channel from preset A
+ * to preset B in MORPH_STEPS detents. Times are interpolated in encoder
+ * steps, which are already log time, so the halfway point between 10ms
+ * and 1s is 100ms. Sustain is interpolated as a level.
+ *
+ * A detent recomputes each value with one multiply and divide, then
+ * publishes only the values whose step actually changed: the global,
+ * the encoder target and the envelope setter, like an encoder turn.
+ * Times come from the log-time tables, so no pow() runs while sweeping.
+ * The setters are single word stores on core0, core1 just sees new
+ * values on its next frame.
+ * */
+
+#ifndef MORPH_H
+#define MORPH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define MORPH_STEPS 64 // Encoder detents from A to B
+
+extern int morphSlotA; // 0-based preset slots
+extern int morphSlotB;
+extern int morphPosition;                // 0 (A) to MORPH_STEPS (B)
+extern uint32_t morphValuesPublished;    // Parameters changed by the last detent
+extern uint32_t morphLastUpdateCycles;   // Cost of the last detent, recompute and publish
+
+bool morphEnter(int slotA, int slotB); // Reads both slots, false if either is missing or invalid
+void morphService();                   // From loop(), follows encoder 1 on the morph screen
+void morphDraw();
+void printMorph();
+
+#endif
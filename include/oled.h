@@ -5,10 +5,22 @@
 #include <U8g2lib.h>
 #include "config.h"
 
-extern bool oledUpdateNeeded;            // Flag to indicate if an update is needed
+#define OLED_REFRESH_INTERVAL_MS 50 // At most one frame per interval
+
+extern U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2;
+extern const uint8_t *smallFont;
+
+extern uint32_t uiVersion;               // Bump when anything on screen other than the ADSR parameters changes
+extern uint32_t oledFramesSent;          // Frames sent to the display since boot
+extern uint32_t oledLastFrameBytes;      // Display data bytes in the last frame, only changed tiles are sent
+extern uint32_t oledLastFrameUs;         // I2C transfer time of the last frame
+extern uint32_t oledLastBlockedUs;       // Time core0 spent sending the last frame
+extern uint32_t oledLastComposeUs;       // Time spent drawing the last frame into the buffer
 
 void oledSetup();
 void oledUpdate();
+void printOledStats();
+void sendChangedTiles();
 void clearArea(int x, int y, int width, int height, int flash);
 void drawAngleLine(int centerX, int centerY, int radius, float startAngle, float rangeDegrees, int value, int minRange, int maxRange);
 void drawAngleWedge(int centerX, int centerY, int radius, float startAngle, float rangeDegrees, int lowValue, int highValue, int minRange, int maxRange);
@@ -19,6 +31,8 @@ int getOctave (int inputInteger);
 String getNoteName(int inputInteger); // Chromatic scale only
 void saveOrLoadState();
 void displayMenuState();
+void updateMenuHighlight();
+void menuSelect();
 void enterMenu();
 
 #endif // OLED_H
\ No newline at end of file
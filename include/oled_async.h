@@ -0,0 +1,22 @@
+#ifndef OLED_ASYNC_H
+#define OLED_ASYNC_H
+
+#include <Arduino.h>
+
+// 1 = send display areas with DMA on the I2C hardware, oledUpdate() never waits for the panel
+// 0 = blocking sends through U8g2
+#ifndef OLED_ASYNC_I2C
+#define OLED_ASYNC_I2C 1
+#endif
+
+#define OLED_I2C_ADDRESS 0x3C // SSD1306, 7 bit address
+
+extern bool oledAsync;                      // DMA path running, set by oledAsyncBegin()
+extern uint32_t oledAsyncLastTransferUs;    // Start to last byte on the bus, for the last transfer
+
+bool oledAsyncBegin(); // After u8g2.begin(), which sets up the I2C pins and clock
+bool oledAsyncBusy();  // True while a transfer is on the bus, notes the completion time when it finishes
+void oledAsyncAddArea(int row, int column, const uint8_t *data, int length);
+void oledAsyncSend();
+
+#endif
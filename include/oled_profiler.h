@@ -0,0 +1,22 @@
+#ifndef OLED_PROFILER_H
+#define OLED_PROFILER_H
+
+#include <Arduino.h>
+
+// Profiler overlay: frame and core load figures drawn over whichever screen is showing,
+// for checking a module in the rack without a serial cable. Turned on and off from the menu.
+#define PROFILER_INTERVAL_MS 500 // Figures are recalculated, and the overlay redrawn, this often
+
+extern bool profilerOverlay;
+
+// Counters kept by loop() and loop1() in main.cpp
+extern uint32_t core0Loops;                  // loop() passes, free running
+extern uint32_t core0DrawCycles;             // CPU cycles spent in oledUpdate(), free running
+extern volatile uint32_t core1RenderCycles;  // Smoothed cycles per frame
+extern volatile uint32_t core1WriteCycles;
+
+void profilerToggle();
+bool profilerUpdate(); // Recalculates once per PROFILER_INTERVAL_MS, true when the figures changed
+void profilerDraw();   // On top of the composed frame
+
+#endif
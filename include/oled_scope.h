@@ -0,0 +1,19 @@
+#ifndef OLED_SCOPE_H
+#define OLED_SCOPE_H
+
+#include <Arduino.h>
+
+// Scope screen: the last SCOPE_COLUMNS * SCOPE_COLUMN_US of DAC output, read from the output trace
+#define SCOPE_COLUMNS 128
+#define SCOPE_COLUMN_US 25000 // One pixel column per 25ms, a 3.2s window
+#define SCOPE_TRACE_RATE 1000 // Trace frames per second the scope asks core1 for
+
+extern bool scopeAllChannels; // Show the four channels on the current page, or just the selected one
+
+void scopeEnter(bool allChannels);
+void scopeExit();
+int scopeReadSamples();       // Take new trace frames, returns the number of new columns
+void scopeDraw();             // Whole screen from the stored history
+void scopeScroll(int columns); // Shift the plot left and draw only the new columns
+
+#endif
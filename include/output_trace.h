@@ -0,0 +1,66 @@
+/**
+ * Output trace
+ *
+ * Core1 records the frames it sends to the DACs into a ring, core0 reads
+ * them back for the display, logging or export. One writer and any number
+ * of readers, each with its own cursor. The writer never waits: a reader
+ * that falls more than a ring behind loses the oldest frames and is told
+ * how many.
+ *
+ * ```
+ * outputTraceDecimation = 10; // every 10th frame
+ *
+ * OutputTraceReader reader;
+ * OutputTraceFrame frames[16];
+ * int n = readOutputTrace(reader, frames, 16);
+ * ```
+ * */
+
+#ifndef OUTPUT_TRACE_H
+#define OUTPUT_TRACE_H
+
+#include <Arduino.h>
+#include <hardware/sync.h>
+#include "config.h"
+
+#define OUTPUT_TRACE_FRAMES 256 // must be a power of 2
+
+struct OutputTraceFrame
+{
+    uint32_t time_us; // time_us_32() when the frame was sent
+    uint16_t values[NUM_CHANNELS];
+};
+
+struct OutputTraceReader
+{
+    uint32_t next = 0;    // Next frame to read
+    uint32_t dropped = 0; // Frames overwritten before this reader got to them
+};
+
+extern OutputTraceFrame outputTrace[OUTPUT_TRACE_FRAMES];
+extern volatile uint32_t outputTraceHead;       // Frames written, free running
+extern volatile uint32_t outputTraceDecimation; // Record every Nth frame, 0 = off
+extern uint32_t outputTraceSkipped;
+
+// Core1, once per DAC frame
+static inline void traceOutputFrame(const uint16_t *values)
+{
+    if (outputTraceDecimation == 0 || ++outputTraceSkipped < outputTraceDecimation)
+    {
+        return;
+    }
+    outputTraceSkipped = 0;
+
+    uint32_t head = outputTraceHead;
+    OutputTraceFrame &frame = outputTrace[head & (OUTPUT_TRACE_FRAMES - 1)];
+    frame.time_us = time_us_32();
+    memcpy(frame.values, values, sizeof(frame.values));
+    __dmb(); // Frame contents visible to core0 before the new head
+    outputTraceHead = head + 1;
+}
+
+// Core0
+int readOutputTrace(OutputTraceReader &reader, OutputTraceFrame *out, int max);
+void printOutputTrace();
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Preset bank on LittleFS
+ *
+ * Each slot is one small binary file holding every channel's attack,
+ * decay and release (encoder steps on the log-time tables), sustain
+ * level and options, with a version and a CRC-32.
+ *
+ * A save writes the record to a temporary file and renames it over the
+ * slot. LittleFS renames atomically, so after a power cut the slot holds
+ * either the old record or the new one, never part of either. The write
+ * and the rename are separate flash steps run by presetService() when
+ * flash_safe.h allows, so a save never holds the outputs mid-envelope.
+ *
+ * A load reads one fixed-size record, checks it and sets the encoder
+ * targets on core0. Core1 then applies every channel to the envelopes
+ * between two frames, so all channels change in the same frame.
+ * */
+
+#ifndef PRESETS_H
+#define PRESETS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define PRESET_SLOTS 32
+
+// Record layout, little endian as stored. 4 + 10 per channel + 4 bytes: 48 bytes for 4 channels.
+struct PresetChannel
+{
+    uint16_t attack;  // Encoder step, 0 to 1000
+    uint16_t decay;   // Encoder step, 0 to 1000
+    uint16_t sustain; // Level, 0 to 4095
+    uint16_t release; // Encoder step, 0 to 1000
+    uint8_t flags;    // PRESET_FLAG_*
+    uint8_t reserved;
+};
+
+struct PresetRecord
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t channels;
+    PresetChannel channel[NUM_CHANNELS];
+    uint32_t crc; // Of everything before it
+};
+static_assert(sizeof(PresetChannel) == 10, "PresetChannel must be packed");
+static_assert(sizeof(PresetRecord) == 8 + 10 * NUM_CHANNELS, "PresetRecord must be packed");
+
+extern int presetSlot;                       // Slot the menu saves to and loads from, 0-based
+extern volatile bool presetApplyPending;     // Loaded on core0, waiting for core1
+extern uint32_t presetLastLoadUs;            // Open, read, check and decode of the last load
+extern uint32_t presetLastSaveUs;            // Request to rename of the last save, including waits for steady outputs
+extern volatile uint32_t presetApplyCycles;  // Core1 time to apply the last load to the envelopes
+
+// Core0
+void setupPresets(); // After LittleFS.begin(), finds writes cut short by a power cut for presetService() to clear
+bool requestPresetSave(int slot); // Snapshot now, written by presetService(). False while a save is running.
+bool presetSaveBusy();
+void presetService();             // From loop(), runs at most one flash step: a leftover .tmp, or a save
+bool readPreset(int slot, PresetRecord &record); // Checked record from a slot, without applying it
+bool loadPreset(int slot);
+void capturePreset(PresetRecord &record);           // The current settings, CRC filled in
+bool presetRecordValid(const PresetRecord &record);
+void applyPresetRecord(const PresetRecord &record); // As a load does, core1 applies it between frames
+void printPresets();
+void runPresetSaveTest();         // Output frame gaps during saves, plain LittleFS against flash safe
+
+// Core1
+bool applyPendingPreset(); // Between frames, true when a preset was applied
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * Scenes: instant switching between in-RAM settings
+ *
+ * The envelope bank holds NUM_SCENES complete sets of channel settings.
+ * Pressing buttons 1 and 4 together plays the next scene. Core0 only
+ * posts the request; core1 takes it between two frames and switches the
+ * bank's play pointer, one store whatever the channel count, so every
+ * channel changes in the same frame.
+ *
+ * The panel edits the playing scene, or with "Edit: other" in the menu
+ * the next one, which keeps playing unchanged until it is switched to.
+ * Scenes aren't saved, at power-on they all start as scene A.
+ * */
+
+#ifndef SCENES_H
+#define SCENES_H
+
+#include <Arduino.h>
+#include "config.h"
+
+extern bool sceneEditOther;                 // The panel edits the scene after the playing one
+extern volatile int scenePlayRequest;       // Scene for core1 to play next, -1 for none
+extern volatile uint32_t sceneSwitchCycles; // Core1 time of the last switch
+
+// Core0
+void setupScenes(); // After the power-on settings, copies them to every scene
+void sceneSwitch(); // Play the next scene
+void sceneToggleEditOther();
+char sceneLetter(int scene);
+void printScenes();
+
+// Core1
+bool applyPendingScene(); // Between frames, true when a scene was switched
+
+#endif
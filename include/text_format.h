@@ -0,0 +1,19 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <Arduino.h>
+
+// Number to text without printf, String or floats, into a buffer the caller owns.
+// Each returns the characters written, not counting the terminator. The output is always
+// terminated and is cut short if it doesn't fit, so calls can be chained:
+//   int n = formatText(buf, sizeof(buf), "A=");
+//   n += formatDuration(buf + n, sizeof(buf) - n, attackUs);
+
+int formatText(char *buf, int size, const char *text);
+int formatUInt(char *buf, int size, uint32_t value);
+int formatInt(char *buf, int size, int32_t value);
+int formatFixed(char *buf, int size, int32_t value, int decimals);                 // value in 1/10^decimals, 1234,2 -> "12.34"
+int formatPercent(char *buf, int size, uint32_t value, uint32_t full, int decimals); // value/full rounded, without the % sign
+int formatDuration(char *buf, int size, uint32_t us);                              // "850us", "12.5ms", "1.25s", three figures
+
+#endif
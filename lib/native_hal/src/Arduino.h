@@ -0,0 +1,118 @@
+// Native HAL: the subset of the Arduino core API the firmware uses
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <pico/stdlib.h>
+
+#define NATIVE_HAL 1 // Building on the host
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LED_BUILTIN 25
+#define DEC 10
+#define HEX 16
+#define F_CPU 133000000
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// As ArduinoCore-API, mixed argument types allowed
+template <class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template <class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+
+// Placement attributes mean nothing on the host
+#define __not_in_flash_func(name) name
+#define __time_critical_func(name) name
+
+class String
+{
+public:
+    String() {}
+    String(const char *text) : _text(text ? text : "") {}
+    const char *c_str() const { return _text.c_str(); }
+    unsigned int length() const { return _text.size(); }
+    bool startsWith(const String &prefix) const { return _text.compare(0, prefix._text.size(), prefix._text) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return _text.size() >= suffix._text.size() &&
+               _text.compare(_text.size() - suffix._text.size(), suffix._text.size(), suffix._text) == 0;
+    }
+
+private:
+    std::string _text;
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC) { return print((unsigned long long)value, base); }
+    size_t print(long value, int base = DEC) { return print((long long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long long)value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <class T>
+    size_t println(T value) { return print(value) + println(); }
+    template <class T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long baud) {}
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int level);
+int digitalRead(int pin);
+void analogWrite(int pin, int value);
+void analogWriteResolution(int bits);
+
+// The core's rp2040 object: cycle counts come from the clock at F_CPU
+class RP2040
+{
+public:
+    uint32_t getCycleCount();
+    uint64_t getCycleCount64();
+    uint32_t f_cpu() { return F_CPU; }
+    void idleOtherCore() {}
+    void resumeOtherCore() {}
+};
+extern RP2040 rp2040;
+
+#endif
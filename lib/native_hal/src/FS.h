@@ -0,0 +1,85 @@
+// Native HAL: a filesystem held in RAM, empty at start, with the File, Dir and FS calls the
+// firmware makes. Paths are flat strings, so a directory is any prefix ending in '/'.
+#ifndef NATIVE_HAL_FS_H
+#define NATIVE_HAL_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> HalFileMap;
+
+class File
+{
+public:
+    File() {}
+    File(HalFileMap *files, const std::string &path, size_t position)
+        : _files(files), _path(path), _position(position) {}
+
+    size_t read(uint8_t *buffer, size_t size);
+    size_t write(const uint8_t *buffer, size_t size);
+    size_t size();
+    bool seek(uint32_t position);
+    size_t position() const { return _position; }
+    void flush() {}
+    void close() { _files = nullptr; }
+    operator bool() const { return _files != nullptr; }
+
+private:
+    HalFileMap *_files = nullptr;
+    std::string _path;
+    size_t _position = 0;
+};
+
+class Dir
+{
+public:
+    Dir() {}
+    Dir(std::vector<std::string> names) : _names(names) {}
+
+    bool next() { return ++_index < (int)_names.size(); }
+    String fileName() const { return _names[_index].c_str(); }
+
+private:
+    std::vector<std::string> _names;
+    int _index = -1;
+};
+
+// Only what the firmware sets: whether begin() may format a filesystem that won't mount
+class FSConfig
+{
+public:
+    FSConfig &setAutoFormat(bool autoFormat)
+    {
+        _autoFormat = autoFormat;
+        return *this;
+    }
+
+protected:
+    bool _autoFormat = true;
+};
+
+class FS
+{
+public:
+    bool setConfig(const FSConfig &config) { return true; }
+    bool begin() { return true; }
+    void end() {}
+    bool format()
+    {
+        _files.clear();
+        return true;
+    }
+    File open(const char *path, const char *mode);
+    bool exists(const char *path) { return _files.count(path) > 0; }
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+    bool mkdir(const char *path) { return true; }
+    Dir openDir(const char *path);
+
+private:
+    HalFileMap _files;
+};
+
+#endif
@@ -0,0 +1,13 @@
+// Native HAL: LittleFS is the RAM filesystem from FS.h
+#ifndef NATIVE_HAL_LITTLEFS_H
+#define NATIVE_HAL_LITTLEFS_H
+
+#include <FS.h>
+
+class LittleFSConfig : public FSConfig
+{
+};
+
+extern FS LittleFS;
+
+#endif
@@ -0,0 +1,28 @@
+// Native HAL: PicoEncoder with its counts set from the host, see halTurnEncoder()
+#ifndef NATIVE_HAL_PICO_ENCODER_H
+#define NATIVE_HAL_PICO_ENCODER_H
+
+#include <Arduino.h>
+
+class PicoEncoder
+{
+public:
+    int begin(int firstPin, bool pullUp = false) { return 0; }
+    void update() {}
+    void autoCalibratePhases() {}
+    bool autoCalibrationDone() { return true; }
+    uint getPhases() { return 0; }
+
+    // step counts quadrature steps, position is in 1/64 steps
+    void turn(int steps)
+    {
+        step += steps;
+        position += steps * 64;
+    }
+
+    int speed = 0;
+    int position = 0;
+    int step = 0;
+};
+
+#endif
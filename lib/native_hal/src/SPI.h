@@ -0,0 +1,28 @@
+// Native HAL: SPI bus with nothing on it. DAC output on the host goes through DAC_DRIVER_MOCK.
+#ifndef NATIVE_HAL_SPI_H
+#define NATIVE_HAL_SPI_H
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+struct SPISettings
+{
+    SPISettings() {}
+    SPISettings(uint32_t clock, int bitOrder, int dataMode) {}
+};
+
+class SPIClass
+{
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { return 0; }
+    uint16_t transfer16(uint16_t data) { return 0; }
+};
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,77 @@
+// Native HAL: U8g2 with a real frame buffer and no panel. Lines, boxes and pixels are drawn
+// as U8g2 would; text has no glyph data, it only moves the cursor, so widths are approximate.
+#ifndef NATIVE_HAL_U8G2LIB_H
+#define NATIVE_HAL_U8G2LIB_H
+
+#include <Arduino.h>
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+// Fonts are one byte, the advance width in pixels
+extern const uint8_t u8g2_font_tenthinguys_tr[];
+extern const uint8_t u8g2_font_boutique_bitmap_9x9_tr[];
+
+class U8G2 : public Print
+{
+public:
+    static const int WIDTH = 128;
+    static const int HEIGHT = 64;
+
+    bool begin()
+    {
+        initDisplay();
+        setPowerSave(0);
+        return true;
+    }
+    void initDisplay() {}
+    void setPowerSave(int isEnable) { _powerSave = isEnable; }
+    void clearBuffer() { memset(_buffer, 0, sizeof(_buffer)); }
+    void sendBuffer();
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+    uint8_t *getBufferPtr() { return _buffer; }
+    uint8_t getBufferTileWidth() { return WIDTH / 8; }
+    uint8_t getBufferTileHeight() { return HEIGHT / 8; }
+
+    void setFont(const uint8_t *font) { _font = font; }
+    void setFontMode(int isTransparent) {}
+    void setFontDirection(int dir) {}
+    void setDrawColor(int color) { _color = color; }
+    void setCursor(int x, int y)
+    {
+        _cursorX = x;
+        _cursorY = y;
+    }
+    int getStrWidth(const char *text) { return strlen(text) * _charWidth(); }
+
+    void drawPixel(int x, int y);
+    void drawHLine(int x, int y, int w);
+    void drawVLine(int x, int y, int h);
+    void drawLine(int x0, int y0, int x1, int y1);
+    void drawBox(int x, int y, int w, int h);
+    void drawFrame(int x, int y, int w, int h);
+    void drawStr(int x, int y, const char *text);
+
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    int powerSave() const { return _powerSave; }
+
+protected:
+    uint8_t _buffer[WIDTH * HEIGHT / 8] = {};
+    const uint8_t *_font = nullptr;
+    int _color = 1;
+    int _cursorX = 0;
+    int _cursorY = 0;
+    int _powerSave = 1; // Panels come up asleep
+
+    int _charWidth() const { return _font ? _font[0] : 6; }
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C : public U8G2
+{
+public:
+    U8G2_SSD1306_128X64_NONAME_F_HW_I2C(int rotation, int reset = U8X8_PIN_NONE, int clock = U8X8_PIN_NONE, int data = U8X8_PIN_NONE) {}
+};
+
+#endif
@@ -0,0 +1,19 @@
+// Native HAL: I2C bus with nothing on it, the display goes through U8g2lib.h
+#ifndef NATIVE_HAL_WIRE_H
+#define NATIVE_HAL_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire
+{
+public:
+    void begin() {}
+    void setClock(uint32_t frequency) {}
+    void beginTransmission(uint8_t address) {}
+    uint8_t endTransmission(bool stop = true) { return 0; }
+    size_t write(uint8_t data) { return 1; }
+};
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,29 @@
+// Native HAL: no DMA channels
+#ifndef NATIVE_HAL_HARDWARE_DMA_H
+#define NATIVE_HAL_HARDWARE_DMA_H
+
+#include <pico/stdlib.h>
+
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8,
+    DMA_SIZE_16,
+    DMA_SIZE_32
+};
+
+typedef struct
+{
+    uint32_t ctrl;
+} dma_channel_config;
+
+static inline int dma_claim_unused_channel(bool required) { return -1; }
+static inline dma_channel_config dma_channel_get_default_config(uint channel) { return {0}; }
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {}
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool increment) {}
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool increment) {}
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {}
+static inline void dma_channel_configure(uint channel, const dma_channel_config *c, volatile void *write, const volatile void *read, uint count, bool trigger) {}
+static inline void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read, uint32_t count) {}
+static inline bool dma_channel_is_busy(uint channel) { return false; }
+
+#endif
@@ -0,0 +1,30 @@
+// Native HAL: an idle I2C block, enough for oled_async.cpp to build. No DMA channel is
+// ever free (hardware/dma.h), so the display takes U8g2's blocking path.
+#ifndef NATIVE_HAL_HARDWARE_I2C_H
+#define NATIVE_HAL_HARDWARE_I2C_H
+
+#include <pico/stdlib.h>
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_STATUS_TFE_BITS 0x00000004u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x00000020u
+
+typedef struct
+{
+    volatile uint32_t enable;
+    volatile uint32_t tar;
+    volatile uint32_t status;
+    volatile uint32_t data_cmd;
+} i2c_hw_t;
+
+typedef struct i2c_inst
+{
+    i2c_hw_t hw;
+} i2c_inst_t;
+
+extern i2c_inst_t *i2c0;
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) { return &i2c->hw; }
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) { return 0; }
+
+#endif
@@ -0,0 +1,11 @@
+// Native HAL: no interrupts
+#ifndef NATIVE_HAL_HARDWARE_IRQ_H
+#define NATIVE_HAL_HARDWARE_IRQ_H
+
+#include <pico/stdlib.h>
+
+#define TIMER_IRQ_0 0
+
+static inline void irq_set_enabled(uint num, bool enabled) {}
+
+#endif
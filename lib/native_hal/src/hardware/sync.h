@@ -0,0 +1,11 @@
+// Native HAL: one thread, nothing to mask
+#ifndef NATIVE_HAL_HARDWARE_SYNC_H
+#define NATIVE_HAL_HARDWARE_SYNC_H
+
+#include <pico/stdlib.h>
+
+static inline uint32_t save_and_disable_interrupts() { return 0; }
+static inline void restore_interrupts(uint32_t status) {}
+static inline void __dmb() {}
+
+#endif
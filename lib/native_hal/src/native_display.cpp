@@ -0,0 +1,130 @@
+#include <U8g2lib.h>
+#include "native_hal.h"
+
+const uint8_t u8g2_font_tenthinguys_tr[] = {6};
+const uint8_t u8g2_font_boutique_bitmap_9x9_tr[] = {5};
+
+static U8G2 *halDisplay = nullptr;
+static uint32_t halDisplayUpdateCount = 0;
+
+void U8G2::sendBuffer()
+{
+    halDisplay = this;
+    halDisplayUpdateCount++;
+}
+
+void U8G2::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+    halDisplay = this;
+    halDisplayUpdateCount++;
+}
+
+// Colour 0 clears, 1 sets, 2 inverts, as setDrawColor()
+void U8G2::drawPixel(int x, int y)
+{
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+    {
+        return;
+    }
+    uint8_t &column = _buffer[(y / 8) * WIDTH + x];
+    uint8_t bit = 1 << (y % 8);
+    if (_color == 0)
+    {
+        column &= ~bit;
+    }
+    else if (_color == 1)
+    {
+        column |= bit;
+    }
+    else
+    {
+        column ^= bit;
+    }
+}
+
+void U8G2::drawHLine(int x, int y, int w)
+{
+    for (int i = 0; i < w; i++)
+    {
+        drawPixel(x + i, y);
+    }
+}
+
+void U8G2::drawVLine(int x, int y, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        drawPixel(x, y + i);
+    }
+}
+
+// Bresenham, both ends included
+void U8G2::drawLine(int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+    while (true)
+    {
+        drawPixel(x0, y0);
+        if (x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+        int e2 = 2 * error;
+        if (e2 >= dy)
+        {
+            error += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            error += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void U8G2::drawBox(int x, int y, int w, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        drawHLine(x, y + i, w);
+    }
+}
+
+void U8G2::drawFrame(int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+    drawHLine(x, y, w);
+    drawHLine(x, y + h - 1, w);
+    drawVLine(x, y + 1, h - 2);
+    drawVLine(x + w - 1, y + 1, h - 2);
+}
+
+void U8G2::drawStr(int x, int y, const char *text)
+{
+    setCursor(x, y);
+    print(text);
+}
+
+size_t U8G2::write(const uint8_t *buffer, size_t size)
+{
+    _cursorX += size * _charWidth();
+    return size;
+}
+
+const uint8_t *halDisplayBuffer()
+{
+    return halDisplay ? halDisplay->getBufferPtr() : nullptr;
+}
+
+uint32_t halDisplayUpdates()
+{
+    return halDisplayUpdateCount;
+}
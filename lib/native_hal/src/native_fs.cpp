@@ -0,0 +1,124 @@
+#include <LittleFS.h>
+#include "native_hal.h"
+
+FS LittleFS;
+
+static uint32_t halFlashWriteUs = 0;
+
+void halSetFlashWriteUs(uint32_t us)
+{
+    halFlashWriteUs = us;
+}
+
+// Writing flash stops the RP2040 for the erase and program, the caller sees the time pass
+static void halFlashWrite()
+{
+    if (halFlashWriteUs)
+    {
+        delayMicroseconds(halFlashWriteUs);
+    }
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    if (!_files)
+    {
+        return 0;
+    }
+    const std::vector<uint8_t> &data = (*_files)[_path];
+    size_t count = _position < data.size() ? min(size, data.size() - _position) : 0;
+    memcpy(buffer, data.data() + _position, count);
+    _position += count;
+    return count;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    if (!_files)
+    {
+        return 0;
+    }
+    std::vector<uint8_t> &data = (*_files)[_path];
+    if (data.size() < _position + size)
+    {
+        data.resize(_position + size);
+    }
+    memcpy(data.data() + _position, buffer, size);
+    _position += size;
+    halFlashWrite();
+    return size;
+}
+
+size_t File::size()
+{
+    return _files ? (*_files)[_path].size() : 0;
+}
+
+bool File::seek(uint32_t position)
+{
+    if (!_files || position > size())
+    {
+        return false;
+    }
+    _position = position;
+    return true;
+}
+
+// "r" needs the file, "w" truncates, "a" appends
+File FS::open(const char *path, const char *mode)
+{
+    HalFileMap::iterator file = _files.find(path);
+    if (mode[0] == 'r')
+    {
+        return file == _files.end() ? File() : File(&_files, path, 0);
+    }
+    if (mode[0] == 'w' || file == _files.end())
+    {
+        _files[path].clear();
+        return File(&_files, path, 0);
+    }
+    return File(&_files, path, file->second.size());
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    HalFileMap::iterator file = _files.find(from);
+    if (file == _files.end())
+    {
+        return false;
+    }
+    halFlashWrite();
+    std::vector<uint8_t> data = file->second;
+    _files.erase(file);
+    _files[to] = data;
+    return true;
+}
+
+bool FS::remove(const char *path)
+{
+    if (_files.erase(path) == 0)
+    {
+        return false;
+    }
+    halFlashWrite();
+    return true;
+}
+
+// Names relative to path, as LittleFS gives them
+Dir FS::openDir(const char *path)
+{
+    std::string prefix = path;
+    if (prefix.empty() || prefix.back() != '/')
+    {
+        prefix += '/';
+    }
+    std::vector<std::string> names;
+    for (const HalFileMap::value_type &file : _files)
+    {
+        if (file.first.compare(0, prefix.size(), prefix) == 0 && file.first.find('/', prefix.size()) == std::string::npos)
+        {
+            names.push_back(file.first.substr(prefix.size()));
+        }
+    }
+    return Dir(names);
+}
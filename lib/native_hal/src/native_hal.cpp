@@ -0,0 +1,201 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <PicoEncoder.h>
+#include <hardware/i2c.h>
+#include "native_hal.h"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+RP2040 rp2040;
+SPIClass SPI;
+TwoWire Wire;
+TwoWire Wire1;
+
+// Idle, transmit FIFO empty
+static i2c_inst_t halI2c0 = {{0, 0, I2C_IC_STATUS_TFE_BITS, 0}};
+i2c_inst_t *i2c0 = &halI2c0;
+
+// The firmware's encoders, see encoder.cpp
+extern PicoEncoder encoder1;
+extern PicoEncoder encoder2;
+extern PicoEncoder encoder3;
+extern PicoEncoder encoder4;
+
+// Clock
+
+static const std::chrono::steady_clock::time_point halStart = std::chrono::steady_clock::now();
+static std::atomic<bool> halVirtualClock(false);
+static std::atomic<uint64_t> halVirtualNs(0);
+static std::atomic<uint32_t> halClockReadStepNs(0);
+
+void halUseVirtualClock(bool virtualClock)
+{
+    halVirtualNs = halTimeNs();
+    halVirtualClock = virtualClock;
+}
+
+void halAdvanceUs(uint64_t us)
+{
+    halVirtualNs += us * 1000;
+}
+
+void halSetClockReadStepNs(uint32_t ns)
+{
+    halClockReadStepNs = ns;
+}
+
+uint64_t halTimeNs()
+{
+    if (halVirtualClock)
+    {
+        return halVirtualNs.fetch_add(halClockReadStepNs);
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - halStart).count();
+}
+
+uint64_t halTimeUs()
+{
+    return halTimeNs() / 1000;
+}
+
+unsigned long millis()
+{
+    return halTimeUs() / 1000;
+}
+
+unsigned long micros()
+{
+    return halTimeUs();
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (halVirtualClock)
+    {
+        halAdvanceUs(us);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void delay(unsigned long ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+uint32_t RP2040::getCycleCount()
+{
+    return getCycleCount64();
+}
+
+uint64_t RP2040::getCycleCount64()
+{
+    return halTimeNs() * (F_CPU / 1000000) / 1000;
+}
+
+// Pins
+
+static std::atomic<int> halPins[HAL_PINS];
+
+void halSetPin(int pin, int level)
+{
+    if (pin >= 0 && pin < HAL_PINS)
+    {
+        halPins[pin] = level ? HIGH : LOW;
+    }
+}
+
+int halGetPin(int pin)
+{
+    return pin >= 0 && pin < HAL_PINS ? (int)halPins[pin] : LOW;
+}
+
+void pinMode(int pin, int mode)
+{
+    if (mode == INPUT_PULLUP)
+    {
+        halSetPin(pin, HIGH);
+    }
+}
+
+void digitalWrite(int pin, int level)
+{
+    halSetPin(pin, level);
+}
+
+int digitalRead(int pin)
+{
+    return halGetPin(pin);
+}
+
+void analogWrite(int pin, int value)
+{
+}
+
+void analogWriteResolution(int bits)
+{
+}
+
+// Encoders
+
+void halTurnEncoder(int encoder, int steps)
+{
+    PicoEncoder *encoders[] = {&encoder1, &encoder2, &encoder3, &encoder4};
+    if (encoder >= 1 && encoder <= 4)
+    {
+        encoders[encoder - 1]->turn(steps);
+    }
+}
+
+// Serial
+
+static FILE *halSerialFile = stdout;
+
+void halSerialTo(FILE *file)
+{
+    halSerialFile = file;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return halSerialFile ? fwrite(buffer, 1, size, halSerialFile) : size;
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+    char text[65];
+    int n = 0;
+    do
+    {
+        int digit = value % base;
+        text[n++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value);
+
+    char reversed[65];
+    for (int i = 0; i < n; i++)
+    {
+        reversed[i] = text[n - 1 - i];
+    }
+    return write((const uint8_t *)reversed, n);
+}
+
+size_t Print::print(long long value, int base)
+{
+    if (value < 0 && base == DEC)
+    {
+        return print('-') + print(-(unsigned long long)value, base);
+    }
+    return print((unsigned long long)value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char text[64];
+    int n = snprintf(text, sizeof(text), "%.*f", digits, value);
+    return write((const uint8_t *)text, n);
+}
@@ -0,0 +1,56 @@
+/**
+ * Native HAL
+ *
+ * Host stand-ins for the parts of the Arduino core, the Pico SDK and the
+ * libraries the firmware uses, so the engine, input handling and DAC path
+ * build and run on Linux ([env:native] in platformio.ini). Only the pieces
+ * the sources call are provided, and hardware that isn't there reports
+ * itself missing (no DMA channel, mock DAC driver) so the firmware takes
+ * its fallback paths.
+ *
+ * This header is the host side: the clock, the pins and the encoders can
+ * be driven from a host program or test, and the display and filesystem
+ * inspected.
+ *
+ * Time runs from the host's monotonic clock by default. With a virtual
+ * clock it only moves with halAdvanceUs() and delay(), so runs are
+ * repeatable.
+ *
+ * main() comes from native_main.cpp. Programs with their own, like the
+ * simulator, build with NATIVE_HAL_NO_MAIN.
+ * */
+
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define HAL_PINS 32
+
+// Clock
+void halUseVirtualClock(bool virtualClock);
+void halAdvanceUs(uint64_t us);
+void halSetClockReadStepNs(uint32_t ns); // Virtual clock moves this much per read, so a spin on it still ends
+uint64_t halTimeUs();
+uint64_t halTimeNs();
+
+// Serial output, stdout by default, nullptr discards it
+void halSerialTo(FILE *file);
+
+// Pins, inputs idle high as with INPUT_PULLUP
+void halSetPin(int pin, int level);
+int halGetPin(int pin);
+
+// Encoders, by number 1 to 4 as in encoder.cpp. One detent is 4 steps.
+void halTurnEncoder(int encoder, int steps);
+
+// Display frame buffer as U8g2 keeps it, 8 pages of 128 columns
+const uint8_t *halDisplayBuffer();
+uint32_t halDisplayUpdates(); // updateDisplayArea() and sendBuffer() calls
+
+// Filesystem: each write, rename and remove takes this long, as a flash erase and program
+// would. 0 by default.
+void halSetFlashWriteUs(uint32_t us);
+
+#endif
@@ -0,0 +1,70 @@
+// Native HAL: runs the firmware on the host. Core1 is a thread of its own, as it is a core of
+// its own on the RP2040, and core0 is the main thread.
+//
+//   program [--seconds N]   run for N seconds (default 2), then exit
+//   program --bench         start up, print the microbenchmarks (bench.h), then exit
+#ifndef NATIVE_HAL_NO_MAIN
+
+#include <Arduino.h>
+#include "native_hal.h"
+#include <atomic>
+#include <thread>
+
+void setup();
+void loop();
+void setup1();
+void loop1();
+bool bootComplete();
+void runBenchmarks();
+
+static std::atomic<bool> halRunning(true);
+
+static void halCore1()
+{
+    setup1();
+    while (halRunning)
+    {
+        loop1();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 2;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            bench = true;
+        }
+    }
+
+    std::thread core1(halCore1);
+    setup();
+    if (bench)
+    {
+        while (!bootComplete())
+        {
+            loop();
+        }
+        runBenchmarks();
+        seconds = 0;
+    }
+    uint64_t end = halTimeUs() + (uint64_t)(seconds * 1000000);
+    while (halTimeUs() < end)
+    {
+        loop();
+    }
+
+    halRunning = false;
+    core1.join();
+    fflush(stdout);
+    return 0;
+}
+
+#endif
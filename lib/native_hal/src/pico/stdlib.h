@@ -0,0 +1,21 @@
+// Native HAL: Pico SDK time and basic types
+#ifndef NATIVE_HAL_PICO_STDLIB_H
+#define NATIVE_HAL_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+uint64_t halTimeUs();
+
+static inline absolute_time_t get_absolute_time() { return halTimeUs(); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t time_us_32() { return (uint32_t)halTimeUs(); }
+static inline uint64_t time_us_64() { return halTimeUs(); }
+static inline void tight_loop_contents() {}
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#endif
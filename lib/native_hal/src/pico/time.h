@@ -0,0 +1,7 @@
+// Native HAL: no hardware alarms, build with DAC_FIFO_DEPTH=0
+#ifndef NATIVE_HAL_PICO_TIME_H
+#define NATIVE_HAL_PICO_TIME_H
+
+#include <pico/stdlib.h>
+
+#endif
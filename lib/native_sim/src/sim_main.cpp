@@ -0,0 +1,338 @@
+/**
+ * Simulator
+ *
+ * Runs the whole firmware, both loops, against a virtual clock: each pass
+ * moves the clock to the next frame time, delivers the scenario's events
+ * that are due, then runs loop() and loop1() once. No time is spent
+ * waiting, so an hour of one frame per millisecond takes seconds. Every
+ * frame loop1() sends is read back from the output trace and written out.
+ *
+ *   sim [-j N] [--format csv|wav|none] [--out DIR] [--decimate N] [--serial] scenario...
+ *
+ * Each scenario runs in a process of its own, since the firmware's state
+ * is global, up to N at once (default: one per host core). The exit code
+ * is non-zero if any scenario fails to load, write or meet its expects.
+ *
+ * One pass is one frame, so the firmware sees time in whole frames: a
+ * button held for 100ms is 100 passes at 1000 frames/s. Each flash write
+ * (a preset save or an autosave, say) takes SIM_FLASH_WRITE_US of virtual
+ * time, as on the hardware. Core1 can't be parked while core0 writes, so
+ * those steps also wait out FLASH_SAFE_PARK_TIMEOUT_US with no frames.
+ * */
+
+#include <Arduino.h>
+#include "native_hal.h"
+#include "sim_scenario.h"
+#include "sim_output.h"
+#include "config.h"
+#include "output_trace.h"
+#include "boot.h"
+#include "encoder_read.h"
+#include "factory_presets.h"
+#include "presets.h"
+#include "dac.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+void setup();
+void loop();
+void setup1();
+void loop1();
+
+// Each clock read moves the virtual clock on a little, like the time a real read takes, so the
+// firmware's spin-waits on the clock still end
+const uint32_t SIM_CLOCK_READ_STEP_NS = 10;
+
+// A 4 KB sector erase on the Pico's flash, typically 45 ms, and the program after it
+const uint32_t SIM_FLASH_WRITE_US = 50000;
+
+struct SimOptions
+{
+    SimFormat format = SIM_CSV;
+    std::string outDir = ".";
+    uint32_t decimate = 1;
+    bool serial = false;
+};
+
+static void simApply(const SimEvent &event)
+{
+    const int gatePins[NUM_GATES] = {GATE_1_PIN, GATE_2_PIN, GATE_3_PIN, GATE_4_PIN};
+    const int buttonPins[4] = {BUTTON_1_PIN, BUTTON_2_PIN, BUTTON_3_PIN, BUTTON_4_PIN};
+    int ch = event.index;
+    switch (event.type)
+    {
+    case SIM_GATE:
+        halSetPin(gatePins[event.index], event.value ? LOW : HIGH); // The gate inputs invert
+        break;
+    case SIM_BUTTON:
+        halSetPin(buttonPins[event.index], event.value ? LOW : HIGH);
+        break;
+    case SIM_ENCODER:
+        halTurnEncoder(event.index + 1, event.value * 4);
+        break;
+    case SIM_SET:
+        setChannelParameter(ch, event.parameter, event.value);
+        adsr_class[ch].set_attack(adsr_attack[ch]);
+        adsr_class[ch].set_decay(adsr_decay[ch]);
+        adsr_class[ch].set_sustain(adsr_sustain[ch]);
+        adsr_class[ch].set_release(adsr_release[ch]);
+        paramsVersion++;
+        break;
+    case SIM_SHAPE:
+        applyFactoryPreset(ch, event.value);
+        break;
+    case SIM_SAVE:
+        requestPresetSave(event.index);
+        break;
+    default:
+        break;
+    }
+}
+
+static std::string formatSeconds(uint64_t us)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.3fs", us / 1e6);
+    return text;
+}
+
+// In the child process. Returns the number of failures.
+static int simRun(const SimScenario &scenario, const SimOptions &options)
+{
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+    halUseVirtualClock(true);
+    halSetClockReadStepNs(SIM_CLOCK_READ_STEP_NS);
+    halSerialTo(options.serial ? stderr : nullptr);
+    halSetFlashWriteUs(SIM_FLASH_WRITE_US);
+
+    setup1();
+    setup();
+    while (!bootComplete())
+    {
+        loop();
+        loop1();
+    }
+
+    // loop1() paces itself by dacSamplePeriodUs, zero with the mock driver, so each call is a
+    // frame at the time set here
+    outputTraceDecimation = options.decimate;
+    OutputTraceReader reader;
+    reader.next = outputTraceHead;
+
+    std::string path = options.outDir + "/" + scenario.name + (options.format == SIM_WAV ? ".wav" : ".csv");
+    SimWriter writer;
+    if (!writer.open(path.c_str(), options.format, scenario.rateHz / options.decimate, NUM_CHANNELS))
+    {
+        printf("%s: can't write %s\n", scenario.name.c_str(), path.c_str());
+        return 1;
+    }
+
+    uint64_t start = halTimeUs();
+    uint32_t lastTrace = (uint32_t)start;
+    uint64_t traceTime = 0; // Trace times are 32 bit, unwrapped here
+    size_t nextEvent = 0;
+    size_t nextExpect = 0;
+    int expectsFailed = 0;
+    int failed = 0; // Every other check: gap, saves, dropped frames
+    uint64_t frames = 0;
+    dacFrameGapMaxUs = 0;
+    dacFrameGapMovedMaxUs = 0;
+    for (uint64_t frame = 0;; frame++)
+    {
+        uint64_t frameTime = frame * 1000000 / scenario.rateHz;
+        if (frameTime > scenario.endUs)
+        {
+            break;
+        }
+        uint64_t now = halTimeUs() - start;
+        if (now < frameTime)
+        {
+            halAdvanceUs(frameTime - now);
+        }
+        while (nextEvent < scenario.events.size() && scenario.events[nextEvent].timeUs <= frameTime)
+        {
+            simApply(scenario.events[nextEvent++]);
+        }
+
+        loop();
+        loop1();
+
+        OutputTraceFrame traced[16];
+        int count;
+        while ((count = readOutputTrace(reader, traced, 16)) > 0)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                traceTime += traced[i].time_us - lastTrace;
+                lastTrace = traced[i].time_us;
+                writer.frame(traceTime, traced[i].values);
+                frames++;
+
+                while (nextExpect < scenario.expects.size() && scenario.expects[nextExpect].timeUs <= traceTime)
+                {
+                    const SimEvent &expect = scenario.expects[nextExpect++];
+                    int value = traced[i].values[expect.index];
+                    if (value < expect.value || value > expect.max)
+                    {
+                        printf("%s:%d: expected ch%d %d..%d at %s, got %d at %s\n", scenario.path.c_str(), expect.line,
+                               expect.index + 1, expect.value, expect.max, formatSeconds(expect.timeUs).c_str(), value,
+                               formatSeconds(traceTime).c_str());
+                        expectsFailed++;
+                    }
+                }
+            }
+        }
+    }
+    writer.close();
+
+    // Expects past the last frame were never checked
+    for (; nextExpect < scenario.expects.size(); nextExpect++)
+    {
+        printf("%s:%d: expect after the end of the run\n", scenario.path.c_str(), scenario.expects[nextExpect].line);
+        expectsFailed++;
+    }
+    if (scenario.maxGapUs && dacFrameGapMovedMaxUs > scenario.maxGapUs)
+    {
+        printf("%s: a frame that moved the output came %uus after the one before, gap allows %lluus\n",
+               scenario.path.c_str(), dacFrameGapMovedMaxUs, (unsigned long long)scenario.maxGapUs);
+        failed++;
+    }
+    if (presetSaveBusy())
+    {
+        printf("%s: preset save still waiting at the end\n", scenario.path.c_str());
+        failed++;
+    }
+    for (const SimEvent &event : scenario.events)
+    {
+        PresetRecord record;
+        if (event.type == SIM_SAVE && !readPreset(event.index, record))
+        {
+            printf("%s:%d: preset %d not saved\n", scenario.path.c_str(), event.line, event.index + 1);
+            failed++;
+        }
+    }
+    if (reader.dropped)
+    {
+        printf("%s: %u frames dropped from the trace\n", scenario.name.c_str(), reader.dropped);
+        failed++;
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("%s: %llu frames, %s simulated in %.2fs (%.0fx), expects %d/%d",
+           scenario.name.c_str(), (unsigned long long)frames, formatSeconds(scenario.endUs).c_str(), wall,
+           scenario.endUs / 1e6 / wall, (int)scenario.expects.size() - expectsFailed, (int)scenario.expects.size());
+    if (failed)
+    {
+        printf(", other checks failed: %d", failed);
+    }
+    if (options.format != SIM_NONE)
+    {
+        printf(" -> %s", path.c_str());
+    }
+    printf("\n");
+    return expectsFailed + failed;
+}
+
+static int simUsage()
+{
+    fprintf(stderr, "usage: sim [-j N] [--format csv|wav|none] [--out DIR] [--decimate N] [--serial] scenario...\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions options;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<SimScenario> scenarios;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-j" && hasValue)
+        {
+            jobs = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--format" && hasValue)
+        {
+            std::string format = argv[++i];
+            if (format == "csv")
+                options.format = SIM_CSV;
+            else if (format == "wav")
+                options.format = SIM_WAV;
+            else if (format == "none")
+                options.format = SIM_NONE;
+            else
+                return simUsage();
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            options.outDir = argv[++i];
+        }
+        else if (arg == "--decimate" && hasValue)
+        {
+            options.decimate = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--serial")
+        {
+            options.serial = true;
+        }
+        else if (arg[0] == '-')
+        {
+            return simUsage();
+        }
+        else
+        {
+            // Loaded up front so a bad file stops the run before anything starts
+            SimScenario scenario;
+            std::string error;
+            if (!loadScenario(argv[i], scenario, error))
+            {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 2;
+            }
+            scenarios.push_back(scenario);
+        }
+    }
+    if (scenarios.empty())
+    {
+        return simUsage();
+    }
+
+    // One process per scenario, at most jobs at a time
+    fflush(stdout);
+    int running = 0;
+    int failed = 0;
+    for (size_t i = 0; i <= scenarios.size(); i++)
+    {
+        while (running > 0 && (running >= jobs || i == scenarios.size()))
+        {
+            int status;
+            wait(&status);
+            running--;
+            failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+        if (i == scenarios.size())
+        {
+            break;
+        }
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int result = simRun(scenarios[i], options);
+            fflush(stdout);
+            _exit(result ? 1 : 0);
+        }
+        if (pid < 0)
+        {
+            perror("fork");
+            failed++;
+            continue;
+        }
+        running++;
+    }
+
+    printf("%d scenarios, %d failed\n", (int)scenarios.size(), failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#include "sim_output.h"
+
+static void writeLe(FILE *file, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        fputc((value >> (8 * i)) & 0xFF, file);
+    }
+}
+
+bool SimWriter::open(const char *path, SimFormat format, uint32_t sampleRate, int channels)
+{
+    _format = format;
+    _channels = channels;
+    _sampleRate = sampleRate;
+    _frames = 0;
+    if (format == SIM_NONE)
+    {
+        return true;
+    }
+
+    _file = fopen(path, "wb");
+    if (!_file)
+    {
+        return false;
+    }
+    setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+
+    if (format == SIM_WAV)
+    {
+        _writeWavHeader(); // Sizes filled in by close()
+    }
+    else
+    {
+        fputs("time_us", _file);
+        for (int ch = 0; ch < channels; ch++)
+        {
+            fprintf(_file, ",ch%d", ch + 1);
+        }
+        fputc('\n', _file);
+    }
+    return true;
+}
+
+void SimWriter::frame(uint64_t timeUs, const uint16_t *values)
+{
+    _frames++;
+    if (!_file)
+    {
+        return;
+    }
+    if (_format == SIM_WAV)
+    {
+        for (int ch = 0; ch < _channels; ch++)
+        {
+            writeLe(_file, (uint16_t)(int16_t)(values[ch] * 16 - 32768), 2);
+        }
+        return;
+    }
+    fprintf(_file, "%llu", (unsigned long long)timeUs);
+    for (int ch = 0; ch < _channels; ch++)
+    {
+        fprintf(_file, ",%u", values[ch]);
+    }
+    fputc('\n', _file);
+}
+
+void SimWriter::close()
+{
+    if (!_file)
+    {
+        return;
+    }
+    if (_format == SIM_WAV)
+    {
+        fseek(_file, 0, SEEK_SET);
+        _writeWavHeader();
+    }
+    fclose(_file);
+    _file = nullptr;
+}
+
+// 16 bit PCM, one channel per output
+void SimWriter::_writeWavHeader()
+{
+    uint32_t blockAlign = _channels * 2;
+    uint32_t dataBytes = _frames * blockAlign;
+    fputs("RIFF", _file);
+    writeLe(_file, 36 + dataBytes, 4);
+    fputs("WAVEfmt ", _file);
+    writeLe(_file, 16, 4);
+    writeLe(_file, 1, 2); // PCM
+    writeLe(_file, _channels, 2);
+    writeLe(_file, _sampleRate, 4);
+    writeLe(_file, _sampleRate * blockAlign, 4);
+    writeLe(_file, blockAlign, 2);
+    writeLe(_file, 16, 2);
+    fputs("data", _file);
+    writeLe(_file, dataBytes, 4);
+}
@@ -0,0 +1,33 @@
+// Frame output for the simulator: CSV with the time and one column per channel, or a WAV
+// with one 16 bit channel per output, the DAC's 0-4095 scaled to full range
+#ifndef SIM_OUTPUT_H
+#define SIM_OUTPUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+enum SimFormat
+{
+    SIM_CSV,
+    SIM_WAV,
+    SIM_NONE
+};
+
+class SimWriter
+{
+public:
+    bool open(const char *path, SimFormat format, uint32_t sampleRate, int channels);
+    void frame(uint64_t timeUs, const uint16_t *values);
+    void close();
+
+private:
+    FILE *_file = nullptr;
+    SimFormat _format = SIM_NONE;
+    int _channels = 0;
+    uint32_t _frames = 0;
+    uint32_t _sampleRate = 0;
+
+    void _writeWavHeader();
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "sim_scenario.h"
+#include "config.h"
+#include "log_time.h"
+#include "factory_presets.h"
+#include "presets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <sstream>
+
+const uint64_t SIM_BUTTON_PRESS_US = 100000;
+
+// "250ms", "1.5s", "2h" -> µs. Plain 0 is allowed.
+static bool parseTime(const std::string &text, uint64_t &us)
+{
+    char *unit;
+    double value = strtod(text.c_str(), &unit);
+    if (unit == text.c_str() || value < 0)
+    {
+        return false;
+    }
+    double scale;
+    if (strcmp(unit, "us") == 0)
+        scale = 1;
+    else if (strcmp(unit, "ms") == 0)
+        scale = 1e3;
+    else if (strcmp(unit, "s") == 0)
+        scale = 1e6;
+    else if (strcmp(unit, "m") == 0)
+        scale = 60e6;
+    else if (strcmp(unit, "h") == 0)
+        scale = 3600e6;
+    else if (*unit == '\0' && value == 0)
+        scale = 0;
+    else
+        return false;
+    us = (uint64_t)(value * scale + 0.5);
+    return true;
+}
+
+static bool parseInt(const std::string &text, int32_t &value)
+{
+    char *end;
+    long parsed = strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0')
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// 1-based number on the line to an index from 0
+static bool parseIndex(const std::string &text, int count, int &index)
+{
+    int32_t value;
+    if (!parseInt(text, value) || value < 1 || value > count)
+    {
+        return false;
+    }
+    index = value - 1;
+    return true;
+}
+
+// One event line, after the time. False with error set if it doesn't parse.
+static bool parseEvent(const std::vector<std::string> &words, SimEvent &event, std::vector<SimEvent> &extra, std::string &error)
+{
+    const std::string &command = words[0];
+    size_t args = words.size() - 1;
+
+    if (command == "gate" && args == 2 && parseIndex(words[1], NUM_GATES, event.index))
+    {
+        event.type = SIM_GATE;
+        if (words[2] != "on" && words[2] != "off")
+        {
+            error = "gate needs on or off";
+            return false;
+        }
+        event.value = words[2] == "on";
+        return true;
+    }
+    if (command == "button" && args == 2 && parseIndex(words[1], 4, event.index))
+    {
+        event.type = SIM_BUTTON;
+        if (words[2] == "press")
+        {
+            SimEvent up = event;
+            up.timeUs += SIM_BUTTON_PRESS_US;
+            up.value = 0;
+            extra.push_back(up);
+            event.value = 1;
+            return true;
+        }
+        if (words[2] != "down" && words[2] != "up")
+        {
+            error = "button needs down, up or press";
+            return false;
+        }
+        event.value = words[2] == "down";
+        return true;
+    }
+    if (command == "encoder" && args == 2 && parseIndex(words[1], 4, event.index) && parseInt(words[2], event.value))
+    {
+        event.type = SIM_ENCODER;
+        return true;
+    }
+    if (command == "set" && args == 3 && parseIndex(words[1], NUM_CHANNELS, event.index))
+    {
+        event.type = SIM_SET;
+        const char *names[] = {"attack", "decay", "sustain", "release"};
+        event.parameter = -1;
+        for (int i = 0; i < 4; i++)
+        {
+            if (words[2] == names[i])
+            {
+                event.parameter = i;
+            }
+        }
+        if (event.parameter == 2)
+        {
+            if (!parseInt(words[3], event.value) || event.value < 0 || event.value > 4095)
+            {
+                error = "sustain is a level from 0 to 4095";
+                return false;
+            }
+            return true;
+        }
+        uint64_t us;
+        if (event.parameter < 0 || !parseTime(words[3], us))
+        {
+            error = "set needs attack, decay, sustain or release and a value";
+            return false;
+        }
+        // The nearest encoder step at or below the time, as the panel would show it
+        const LogTimeTable &table = event.parameter == 3 ? releaseTimeTable : attackDecayTimeTable;
+        event.value = logTimeToStep(table, (uint32_t)std::min(us, (uint64_t)UINT32_MAX));
+        return true;
+    }
+    if (command == "shape" && args == 2 && parseIndex(words[1], NUM_CHANNELS, event.index))
+    {
+        event.type = SIM_SHAPE;
+        for (int i = 0; i < FACTORY_PRESETS; i++)
+        {
+            if (strcasecmp(words[2].c_str(), factoryPresets[i].name) == 0)
+            {
+                event.value = i;
+                return true;
+            }
+        }
+        error = "no factory shape called " + words[2];
+        return false;
+    }
+    if (command == "save" && args == 1 && parseIndex(words[1], PRESET_SLOTS, event.index))
+    {
+        event.type = SIM_SAVE;
+        return true;
+    }
+    if (command == "expect" && (args == 2 || args == 3) && parseIndex(words[1], NUM_CHANNELS, event.index) &&
+        parseInt(words[2], event.value) && (args == 2 || parseInt(words[3], event.max)))
+    {
+        event.type = SIM_EXPECT;
+        if (args == 2)
+        {
+            event.max = event.value;
+        }
+        return true;
+    }
+    error = "can't read '" + command + "' here";
+    return false;
+}
+
+bool loadScenario(const char *path, SimScenario &scenario, std::string &error)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        error = std::string(path) + ": can't open";
+        return false;
+    }
+
+    scenario = SimScenario();
+    scenario.path = path;
+    scenario.name = path;
+    size_t slash = scenario.name.find_last_of('/');
+    if (slash != std::string::npos)
+    {
+        scenario.name = scenario.name.substr(slash + 1);
+    }
+    scenario.name = scenario.name.substr(0, scenario.name.find('.'));
+
+    char text[256];
+    int line = 0;
+    uint64_t lastTime = 0;
+    bool ended = false;
+    std::vector<SimEvent> events;
+    while (fgets(text, sizeof(text), file))
+    {
+        line++;
+        char *comment = strchr(text, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        std::istringstream stream(text);
+        std::vector<std::string> words;
+        std::string word;
+        while (stream >> word)
+        {
+            words.push_back(word);
+        }
+        if (words.empty())
+        {
+            continue;
+        }
+
+        std::string lineError;
+        if (words[0] == "rate" && words.size() == 2)
+        {
+            int32_t rate = 0;
+            if (!parseInt(words[1], rate) || rate < 1 || rate > 1000000)
+            {
+                lineError = "rate is frames per second, 1 to 1000000";
+            }
+            scenario.rateHz = rate;
+        }
+        else if (words[0] == "gap" && words.size() == 2)
+        {
+            if (!parseTime(words[1], scenario.maxGapUs) || scenario.maxGapUs == 0)
+            {
+                lineError = "gap is a time above 0";
+            }
+        }
+        else
+        {
+            SimEvent event = {};
+            event.line = line;
+            bool relative = words[0][0] == '+';
+            if (!parseTime(words[0].substr(relative ? 1 : 0), event.timeUs))
+            {
+                lineError = "'" + words[0] + "' isn't a time";
+            }
+            else if (words.size() < 2)
+            {
+                lineError = "time with no event";
+            }
+            else
+            {
+                event.timeUs += relative ? lastTime : 0;
+                lastTime = event.timeUs;
+                words.erase(words.begin());
+                if (words[0] == "end" && words.size() == 1)
+                {
+                    scenario.endUs = event.timeUs;
+                    ended = true;
+                }
+                else
+                {
+                    std::vector<SimEvent> extra;
+                    if (parseEvent(words, event, extra, lineError))
+                    {
+                        events.push_back(event);
+                        events.insert(events.end(), extra.begin(), extra.end());
+                    }
+                }
+            }
+        }
+        if (!lineError.empty())
+        {
+            error = std::string(path) + ":" + std::to_string(line) + ": " + lineError;
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+
+    std::stable_sort(events.begin(), events.end(), [](const SimEvent &a, const SimEvent &b)
+                     { return a.timeUs < b.timeUs; });
+    for (const SimEvent &event : events)
+    {
+        (event.type == SIM_EXPECT ? scenario.expects : scenario.events).push_back(event);
+        if (!ended)
+        {
+            scenario.endUs = std::max(scenario.endUs, event.timeUs + 1000000);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+/**
+ * Simulator scenarios
+ *
+ * A scenario is a text file of timed events for the firmware's inputs:
+ *
+ * ```
+ * # 1000 s release, an hour in all
+ * rate 100                    frames per second, default 1000
+ * gap 2ms                     longest wait for a frame that moves the output
+ * 0      set 1 release 1000s  parameter straight in, as a preset load would
+ * 0      gate 1 on
+ * 10s    gate 1 off
+ * +500s  expect 1 1 2000      output code range on channel 1 at this time
+ * 1h     end
+ * ```
+ *
+ * Times are a number and a unit (us, ms, s, m, h), from the end of boot,
+ * or from the previous line with a leading '+'. Events:
+ *   gate <1-4> on|off
+ *   button <1-4> down|up|press   press is down, then up 100ms later
+ *   encoder <1-4> <detents>      negative turns the other way
+ *   set <ch> attack|decay|release <time>
+ *   set <ch> sustain <0-4095>
+ *   shape <ch> <factory shape name>
+ *   save <slot>                  preset save, as from the menu, must be in the slot by the end
+ *   expect <ch> <min> [<max>]    checked against the first frame at or after the time
+ *   end                          default is a second after the last line
+ *
+ * Events reach the firmware the way the hardware would deliver them: gates
+ * and buttons as pin levels and encoders as counts, read by loop() on its
+ * next pass. Only set, shape and save go round the panel.
+ *
+ * With a gap line the run fails if any frame that changes an output comes
+ * later than that after the one before it (dacFrameGapMovedMaxUs). The
+ * simulator gives every flash write the time a real one takes, so a flash
+ * step run mid-envelope shows up as a gap.
+ * */
+
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum SimEventType
+{
+    SIM_GATE,
+    SIM_BUTTON,
+    SIM_ENCODER,
+    SIM_SET,
+    SIM_SHAPE,
+    SIM_SAVE,
+    SIM_EXPECT
+};
+
+struct SimEvent
+{
+    uint64_t timeUs;
+    SimEventType type;
+    int index;     // Gate, button, encoder, channel or preset slot, from 0
+    int parameter; // SIM_SET: 0 attack, 1 decay, 2 sustain, 3 release as setChannelParameter()
+    int32_t value; // Level, detents, encoder step, shape, or the expected minimum
+    int32_t max;   // SIM_EXPECT
+    int line;
+};
+
+struct SimScenario
+{
+    std::string path;
+    std::string name; // File name without directory or extension
+    uint32_t rateHz = 1000;
+    uint64_t endUs = 0;
+    uint64_t maxGapUs = 0; // 0 when there is no gap line
+    std::vector<SimEvent> events;  // Inputs, in time order
+    std::vector<SimEvent> expects; // In time order
+};
+
+bool loadScenario(const char *path, SimScenario &scenario, std::string &error);
+
+#endif
@@ -2,70 +2,109 @@
 #include <math.h>
 #include <SPI.h>
 
-int last_adsr_output = -1;
+ADSR::Tables *ADSR::_tables = nullptr;
 
-ADSR::ADSR(
-    int l_vertical_resolution, 
-    float attack_alpha,
-    float attack_decay_release
-)
+const ADSR::Tables *ADSR::_get_tables(int vertical_resolution, float attack_alpha, float attack_decay_release)
 {
-    // Initialise
-    _vertical_resolution = l_vertical_resolution;
-
-    _attach_alpha = attack_alpha;
-    _attack_decay_release = attack_decay_release;
+    for (Tables *t = _tables; t != nullptr; t = t->next) {
+        if (t->vertical_resolution == vertical_resolution &&
+            t->attack_alpha == attack_alpha &&
+            t->attack_decay_release == attack_decay_release) {
+            return t;
+        }
+    }
 
-    _attack = DEFAULT_ADR_uS;
-    _decay = DEFAULT_ADR_uS;
-    _sustain = l_vertical_resolution * DEFAULT_SUSTAIN_LEVEL;                   
-    _release = DEFAULT_ADR_uS;
+    Tables *t = new Tables;
+    t->vertical_resolution = vertical_resolution;
+    t->attack_alpha = attack_alpha;
+    t->attack_decay_release = attack_decay_release;
 
     // Create look-up table for Attack
     for (int i = 0; i < LUT_SIZE; i++) {
-        _attack_table[i] = i;
-        _decay_release_table[i] = _vertical_resolution - 1 - i;
+        t->attack[i] = i;
+        t->decay_release[i] = vertical_resolution - 1 - i;
     }
 
       // Create look-up table for Decay and Release
     for (int i = 0; i < LUT_SIZE - 1; i++) {
-        _attack_table[i+1] = (1.0 - _attach_alpha) * (_vertical_resolution - 1) + _attach_alpha * _attack_table[i];
-        _decay_release_table[i+1] = _attack_decay_release * _decay_release_table[i];
+        t->attack[i+1] = (1.0 - attack_alpha) * (vertical_resolution - 1) + attack_alpha * t->attack[i];
+        t->decay_release[i+1] = attack_decay_release * t->decay_release[i];
     }
 
     // Normalize tables to min and max
+    int attack_max = t->attack[LUT_SIZE - 1];
+    int decay_release_min = t->decay_release[LUT_SIZE - 1];
+    int decay_release_max = t->decay_release[0];
     for (int i = 0; i < LUT_SIZE; i++) {
-        _attack_table[i] = _map(
-            _attack_table[i], 
+        t->attack[i] = _map(
+            t->attack[i], 
             0, 
-            _attack_table[LUT_SIZE - 1], 
+            attack_max, 
             0, 
-            _vertical_resolution - 1
+            vertical_resolution - 1
         );
         
-        _decay_release_table[i] = _map(
-            _decay_release_table[i], 
-            _decay_release_table[LUT_SIZE - 1], 
-            _decay_release_table[0], 
+        t->decay_release[i] = _map(
+            t->decay_release[i], 
+            decay_release_min, 
+            decay_release_max, 
             0, 
-            _vertical_resolution - 1
+            vertical_resolution - 1
         );
     }
+
+    t->next = _tables;
+    _tables = t;
+    return t;
+}
+
+ADSR::ADSR(
+    int l_vertical_resolution, 
+    float attack_alpha,
+    float attack_decay_release
+)
+{
+    // Initialise
+    _vertical_resolution = l_vertical_resolution;
+
+    _attach_alpha = attack_alpha;
+    _attack_decay_release = attack_decay_release;
+
+    _params.attack = DEFAULT_ADR_uS;
+    _params.decay = DEFAULT_ADR_uS;
+    _params.sustain = l_vertical_resolution * DEFAULT_SUSTAIN_LEVEL;
+    _params.release = DEFAULT_ADR_uS;
+
+    const Tables *tables = _get_tables(_vertical_resolution, _attach_alpha, _attack_decay_release);
+    _attack_table = tables->attack;
+    _decay_release_table = tables->decay_release;
+}
+
+void ADSR::bind_params(Params *const *play_set, Params *const *edit_set, int index)
+{
+    _play_set = play_set;
+    _edit_set = edit_set;
+    _set_index = index;
 }
 
 void ADSR::set_reset_attack(bool l_reset_attack)
 {
-    _reset_attack = l_reset_attack;
+    _edit_params().reset_attack = l_reset_attack;
+}
+
+bool ADSR::get_reset_attack()
+{
+    return _edit_params().reset_attack;
 }
 
 void ADSR::set_attack(unsigned long l_attack)
 {
-    _attack = l_attack;
+    _edit_params().attack = l_attack;
 }
 
 void ADSR::set_decay(unsigned long l_decay)
 {
-    _decay = l_decay;
+    _edit_params().decay = l_decay;
 }
 
 void ADSR::set_sustain(int l_sustain)
@@ -78,20 +117,22 @@ void ADSR::set_sustain(int l_sustain)
         l_sustain = _vertical_resolution - 1;
     }
 
-    _sustain = l_sustain;
+    _edit_params().sustain = l_sustain;
 }
 
 void ADSR::set_release(unsigned long l_release)
 {
-    _release = l_release;
+    _edit_params().release = l_release;
 }
 
 void ADSR::note_on() {
-    _t_note_on = _micros();                   // Set new timestamp for note_on
+    uint64_t now = _micros();
 
     // Set start value new Attack. If _reset_attack equals true, a new trigger starts with 0
-    // otherwise start with the current output
-    _attack_start = _reset_attack ? 0 : _adsr_output;
+    // otherwise start with the output at this moment (frames may have been rendered ahead of it)
+    _attack_start = _play_params().reset_attack ? 0 : _value_at(now);
+
+    _t_note_on = now;                               // Set new timestamp for note_on
     
     _notes_pressed++;                               // increase number of pressed notes with one
 }
@@ -99,8 +140,9 @@ void ADSR::note_on() {
 void ADSR::note_off() {
     _notes_pressed--;
     if (_notes_pressed <= 0) {                      // if all notes are depressed - start release
-        _t_note_off = _micros();                    // set timestamp for note off
-        _release_start = _adsr_output;              // set start value for release
+        uint64_t now = _micros();
+        _release_start = _value_at(now);            // set start value for release
+        _t_note_off = now;                          // set timestamp for note off
         _notes_pressed = 0;
     }
 }
@@ -109,20 +151,54 @@ bool ADSR::is_on() {
     return _notes_pressed >= 1;
 }
 
+// From the rendered value, not the stage times: the decay and release curves settle long
+// before their set times run out (a 1000 s release is at 0 after about 40 s). The last frame
+// rendered has to be there too, or holding the outputs would hold it one step short.
+bool ADSR::is_steady(uint64_t now) const {
+    const Params &p = _play_params();
+    if (_t_note_off == _t_note_on) {
+        return true;                                // never gated, held at 0
+    }
+    if (_t_note_off < _t_note_on) {
+        // Past the attack, and the decay has come down to the sustain level
+        return now >= _t_note_on + p.attack && _adsr_output == p.sustain && _value_at(now) == p.sustain;
+    }
+    return _adsr_output == 0 && _value_at(now) == 0; // released to 0
+}
+
 int ADSR::envelope()
 {
     // Read time once to avoid tiny inconsistencies between multiple _micros() calls
-    uint64_t now = _micros();
-    unsigned long delta = 0;
+    return envelope(_micros());
+}
+
+int ADSR::envelope(uint64_t now)
+{
+    // What reaches the DACs can be watched with the output trace (output_trace.h)
+    _adsr_output = _value_at(now);
+    return _adsr_output;
+}
+
+int ADSR::_value_at(uint64_t now) const
+{
+    // One parameter set for the whole call, it can be switched between frames
+    const Params &p = _play_params();
+    const uint64_t attack = p.attack;
+    const uint64_t decay = p.decay;
+    const int sustain = p.sustain;
+    const uint64_t release = p.release;
+
+    int output = _adsr_output;
+    uint32_t delta = 0;
 
     // if note is pressed
     if (_t_note_off < _t_note_on) {
-        delta = (now > _t_note_on) ? (unsigned long)(now - _t_note_on) : 0;
+        delta = _elapsed(now, _t_note_on);
 
         // Attack
-        if (_attack == 0 || delta < _attack) {
-            unsigned long attack_d = (_attack == 0) ? 0 : delta;
-            float idx_f = (float)(LUT_SIZE - 1) * (float)attack_d / (float)max(1UL, _attack);
+        if (attack == 0 || delta < attack) {
+            uint32_t attack_d = (attack == 0) ? 0 : delta;
+            float idx_f = (float)(LUT_SIZE - 1) * (float)attack_d / (float)max(1UL, attack);
             int idx = (int)floorf(idx_f);
             float frac = idx_f - (float)idx;
             if (idx < 0) { idx = 0; frac = 0.0f; }
@@ -134,12 +210,12 @@ int ADSR::envelope()
 
             float vmax = (float)(_vertical_resolution - 1);
             float out_f = ((table_val / vmax) * (vmax - (float)_attack_start)) + (float)_attack_start;
-            _adsr_output = (int)roundf(out_f);
+            output = (int)roundf(out_f);
 
         // Decay
-        } else if (delta < _attack + _decay) {
-            unsigned long d2 = (now > _t_note_on + _attack) ? (unsigned long)(now - _t_note_on - _attack) : 0;
-            float idx_f = (float)(LUT_SIZE - 1) * (float)d2 / (float)max(1UL, _decay);
+        } else if (delta < attack + decay) {
+            uint32_t d2 = _elapsed(now, _t_note_on + attack);
+            float idx_f = (float)(LUT_SIZE - 1) * (float)d2 / (float)max(1UL, decay);
             int idx = (int)floorf(idx_f);
             float frac = idx_f - (float)idx;
             if (idx < 0) { idx = 0; frac = 0.0f; }
@@ -150,23 +226,23 @@ int ADSR::envelope()
             float table_val = (1.0f - frac) * v0 + frac * v1;
 
             float vmax = (float)(_vertical_resolution - 1);
-            float out_f = ((table_val / vmax) * (vmax - (float)_sustain)) + (float)_sustain;
-            _adsr_output = (int)roundf(out_f);
+            float out_f = ((table_val / vmax) * (vmax - (float)sustain)) + (float)sustain;
+            output = (int)roundf(out_f);
 
         // Sustain is reached
         } else {
-            _adsr_output = _sustain;
+            output = sustain;
         }
     }
 
     // if note not pressed
     if (_t_note_off > _t_note_on) {
-        delta = (now > _t_note_off) ? (unsigned long)(now - _t_note_off) : 0;
+        delta = _elapsed(now, _t_note_off);
 
         // Release
-        if (_release == 0 || delta < _release) {
-            unsigned long rel_d = (_release == 0) ? 0 : delta;
-            float idx_f = (float)(LUT_SIZE - 1) * (float)rel_d / (float)max(1UL, _release);
+        if (release == 0 || delta < release) {
+            uint32_t rel_d = (release == 0) ? 0 : delta;
+            float idx_f = (float)(LUT_SIZE - 1) * (float)rel_d / (float)max(1UL, release);
             int idx = (int)floorf(idx_f);
             float frac = idx_f - (float)idx;
             if (idx < 0) { idx = 0; frac = 0.0f; }
@@ -178,22 +254,13 @@ int ADSR::envelope()
 
             float vmax = (float)(_vertical_resolution - 1);
             float out_f = (table_val / vmax) * (float)_release_start;
-            _adsr_output = (int)roundf(out_f);
+            output = (int)roundf(out_f);
 
         // Release finished
         } else {
-            _adsr_output = 0;
+            output = 0;
         }
     }
 
-    // Debugging output
-    if (last_adsr_output != _adsr_output) {
-        last_adsr_output = _adsr_output;
-     //   Serial.print(_adsr_output);
-       // Serial.print(" - ");
-      //  Serial.print(micros() - _t_note_off);
-      //  Serial.println();
-    }
-
-    return _adsr_output;
+    return output;
 }
\ No newline at end of file
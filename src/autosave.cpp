@@ -0,0 +1,231 @@
+#include "autosave.h"
+#include "presets.h"
+#include "flash_safe.h"
+#include "crc32.h"
+#include "text_format.h"
+#include "config.h"
+#include <LittleFS.h>
+
+struct AutosaveRecord
+{
+    uint32_t sequence; // Increases by one per record, the highest valid one is the latest
+    PresetRecord state;
+    uint32_t crc;      // Of sequence and state
+};
+static_assert(sizeof(AutosaveRecord) == 8 + sizeof(PresetRecord), "AutosaveRecord must be packed");
+
+const char *autosaveDir = "/autosave";
+const int AUTOSAVE_RECORDS_PER_SEGMENT = AUTOSAVE_SEGMENT_BYTES / sizeof(AutosaveRecord);
+
+bool autosaveEnabled = false;   // LittleFS is mounted and the log has been read
+uint32_t autosaveSequence = 0;  // Of the last record written or restored
+int autosaveSegment = 0;        // Segment the next record goes into
+int autosaveSegmentRecords = 0; // Records in it, AUTOSAVE_RECORDS_PER_SEGMENT starts the next one
+PresetRecord autosaveStored;    // What the log holds now
+bool autosaveHasStored = false;
+
+uint32_t autosaveSeenVersion = 0; // paramsVersion when last looked at
+uint32_t autosaveEditTime = 0;    // millis() of the last edit seen
+bool autosaveDirty = false;
+
+uint32_t autosaveWrites = 0;
+uint32_t autosaveSectorsErased = 0;
+uint32_t autosavePagesProgrammed = 0;
+uint32_t autosaveSkipped = 0;
+uint32_t autosaveSegmentsStarted = 0;
+
+static void autosavePath(char *path, int size, int segment)
+{
+    int n = formatText(path, size, autosaveDir);
+    n += formatText(path + n, size - n, "/");
+    n += formatInt(path + n, size - n, segment);
+    formatText(path + n, size - n, ".log");
+}
+
+static uint32_t autosaveCrc(const AutosaveRecord &record)
+{
+    return crc32(&record, offsetof(AutosaveRecord, crc));
+}
+
+// Last valid record of a segment, searching back from the end. Returns its index, -1 for none.
+// clean is false when anything follows that record: a damaged tail is left alone, since appending
+// after it would put records out of step with the record size, and the next write starts the
+// following segment instead.
+static int readSegment(int segment, AutosaveRecord &record, bool &clean)
+{
+    clean = false;
+    char path[32];
+    autosavePath(path, sizeof(path), segment);
+    File file = LittleFS.open(path, "r");
+    if (!file)
+    {
+        return -1;
+    }
+
+    int count = min((int)(file.size() / sizeof(AutosaveRecord)), AUTOSAVE_RECORDS_PER_SEGMENT);
+    int found = -1;
+    for (int i = count - 1; i >= 0 && found < 0; i--)
+    {
+        if (file.seek(i * sizeof(AutosaveRecord)) &&
+            file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+            record.crc == autosaveCrc(record) && presetRecordValid(record.state))
+        {
+            found = i;
+        }
+    }
+    clean = found == count - 1 && file.size() == (size_t)count * sizeof(AutosaveRecord);
+    file.close();
+    return found;
+}
+
+// At boot, with core1 already sending frames: only reads. The directory is made by the first append.
+void restoreAutosave()
+{
+
+    AutosaveRecord record;
+    AutosaveRecord latest;
+    int latestIndex = -1;
+    for (int segment = 0; segment < AUTOSAVE_SEGMENTS; segment++)
+    {
+        bool clean;
+        int index = readSegment(segment, record, clean);
+        if (index >= 0 && (latestIndex < 0 || (int32_t)(record.sequence - latest.sequence) > 0))
+        {
+            latest = record;
+            latestIndex = index;
+            autosaveSegment = segment;
+            autosaveSegmentRecords = clean ? index + 1 : AUTOSAVE_RECORDS_PER_SEGMENT;
+        }
+    }
+    autosaveEnabled = true;
+
+    if (latestIndex < 0)
+    {
+        Serial.println("Autosave: nothing stored, using defaults");
+        return;
+    }
+
+    applyPresetRecord(latest.state);
+    autosaveStored = latest.state;
+    autosaveHasStored = true;
+    autosaveSequence = latest.sequence;
+    autosaveSeenVersion = paramsVersion; // Restoring isn't an edit
+    Serial.print("Autosave: restored record ");
+    Serial.println(autosaveSequence);
+}
+
+// Compare settings only, the CRC follows from them
+static bool sameSettings(const PresetRecord &a, const PresetRecord &b)
+{
+    return memcmp(&a, &b, offsetof(PresetRecord, crc)) == 0;
+}
+
+void autosaveService()
+{
+    if (!autosaveEnabled)
+    {
+        return;
+    }
+
+    // Every edit pushes the save back, so a knob being turned is saved once, when it stops
+    uint32_t now = millis();
+    if (paramsVersion != autosaveSeenVersion)
+    {
+        autosaveSeenVersion = paramsVersion;
+        autosaveEditTime = now;
+        autosaveDirty = true;
+    }
+    if (!autosaveDirty || now - autosaveEditTime < AUTOSAVE_DELAY_MS)
+    {
+        return;
+    }
+
+    AutosaveRecord record;
+    capturePreset(record.state);
+    if (autosaveHasStored && sameSettings(record.state, autosaveStored))
+    {
+        autosaveDirty = false;
+        autosaveSkipped++;
+        return;
+    }
+    if (!flashSafeReady())
+    {
+        return;
+    }
+
+    bool newSegment = autosaveSegmentRecords >= AUTOSAVE_RECORDS_PER_SEGMENT;
+    int segment = newSegment ? (autosaveSegment + 1) % AUTOSAVE_SEGMENTS : autosaveSegment;
+    record.sequence = autosaveSequence + 1;
+    record.crc = autosaveCrc(record);
+
+    char path[32];
+    autosavePath(path, sizeof(path), segment);
+    uint32_t erased = flashSectorsErased;
+    uint32_t programmed = flashPagesProgrammed;
+    flashSafeBegin();
+    if (!LittleFS.exists(autosaveDir))
+    {
+        LittleFS.mkdir(autosaveDir);
+    }
+    File file = LittleFS.open(path, newSegment ? "w" : "a");
+    bool ok = file && file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+    if (file)
+    {
+        file.close();
+    }
+    flashSafeEnd();
+    autosaveSectorsErased += flashSectorsErased - erased;
+    autosavePagesProgrammed += flashPagesProgrammed - programmed;
+
+    if (!ok)
+    {
+        // Try again after another quiet period, from a fresh segment
+        autosaveEditTime = now;
+        autosaveSegmentRecords = AUTOSAVE_RECORDS_PER_SEGMENT;
+        autosaveSegment = segment;
+        Serial.println("Autosave: write failed");
+        return;
+    }
+
+    if (newSegment)
+    {
+        autosaveSegment = segment;
+        autosaveSegmentRecords = 0;
+        autosaveSegmentsStarted++;
+    }
+    autosaveSegmentRecords++;
+    autosaveSequence = record.sequence;
+    autosaveStored = record.state;
+    autosaveHasStored = true;
+    autosaveDirty = false;
+    autosaveWrites++;
+}
+
+// Per hour since boot: records appended, and the erases and page programs they cost, which are
+// the figures to compare against flash endurance
+static void printPerHour(const char *name, uint32_t count, uint32_t uptimeMs)
+{
+    Serial.print(name);
+    Serial.print(count);
+    Serial.print(" (");
+    Serial.print((uint32_t)((uint64_t)count * 3600000 / uptimeMs));
+    Serial.print("/hour)");
+}
+
+void printAutosave()
+{
+    uint32_t uptimeMs = max(1UL, (unsigned long)millis());
+    printPerHour("Autosave records: ", autosaveWrites, uptimeMs);
+    printPerHour(" sectors erased: ", autosaveSectorsErased, uptimeMs);
+    printPerHour(" pages programmed: ", autosavePagesProgrammed, uptimeMs);
+    Serial.print(" skipped: ");
+    Serial.print(autosaveSkipped);
+    Serial.print(" segment ");
+    Serial.print(autosaveSegment);
+    Serial.print(" records ");
+    Serial.print(autosaveSegmentRecords);
+    Serial.print("/");
+    Serial.print(AUTOSAVE_RECORDS_PER_SEGMENT);
+    Serial.print(" segments started: ");
+    Serial.println(autosaveSegmentsStarted);
+}
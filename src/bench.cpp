@@ -0,0 +1,228 @@
+#include "bench.h"
+#include "config.h"
+#include "dac.h"
+#include "encoder_read.h"
+#include "oled.h"
+#include "oled_async.h"
+#include "flash_safe.h"
+#include <PicoEncoder.h>
+#include <adsr.h>
+
+extern PicoEncoder encoder2; // Decay, see encoder.cpp
+
+uint32_t benchCycles[BENCH_RUNS];
+uint32_t benchOverhead = 0; // Cycles for an empty run, taken off every case
+
+// What the run functions work on
+ADSR *benchAdsr = nullptr;
+uint64_t benchTime = 0;
+int benchChannel = 0;
+
+static void benchEmpty(int run)
+{
+}
+
+static void benchEnvelope(int run)
+{
+    benchAdsr->envelope(benchTime + run);
+}
+
+static void benchCacheSame(int run)
+{
+    cacheDacValue(0, 2048);
+}
+
+static void benchCacheChanged(int run)
+{
+    cacheDacValue(0, (run & 1) ? 1024 : 3072);
+}
+
+static void benchChangeAll(int run)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        cacheDacValue(ch, (run & 1) ? 1024 : 3072);
+    }
+}
+
+static void benchDacWrite(int run)
+{
+    dacWrite();
+}
+
+// As loop() calls it, the ranges are set inside
+static void benchReadEncoder(int run)
+{
+    readEncoder(0, 1000, 8, 2, benchChannel);
+}
+
+// A detent forward or back, as encoder2.update() would leave it
+static void benchTurnEncoder(int run)
+{
+    encoder2.step += (run & 1) ? -4 : 4;
+}
+
+static void benchOledUpdate(int run)
+{
+    oledUpdate();
+}
+
+static void benchOledDue(int run)
+{
+    delay(OLED_REFRESH_INTERVAL_MS);
+    while (oledAsyncBusy())
+    {
+    }
+}
+
+static void benchOledRedraw(int run)
+{
+    benchOledDue(run);
+    paramsVersion++;
+}
+
+// Time each run of body, after prepare if there is one, and print a row
+static void benchCase(const char *function, const char *name, int runs, void (*prepare)(int), void (*body)(int))
+{
+    for (int i = 0; i < runs; i++)
+    {
+        if (prepare)
+        {
+            prepare(i);
+        }
+        uint32_t start = rp2040.getCycleCount();
+        body(i);
+        uint32_t cycles = rp2040.getCycleCount() - start;
+        benchCycles[i] = cycles > benchOverhead ? cycles - benchOverhead : 0;
+    }
+
+    // Insertion sort, the runs are few
+    for (int i = 1; i < runs; i++)
+    {
+        uint32_t value = benchCycles[i];
+        int j = i;
+        for (; j > 0 && benchCycles[j - 1] > value; j--)
+        {
+            benchCycles[j] = benchCycles[j - 1];
+        }
+        benchCycles[j] = value;
+    }
+
+    uint32_t median = benchCycles[runs / 2];
+    Serial.print("bench,");
+    Serial.print(function);
+    Serial.print(",");
+    Serial.print(name);
+    Serial.print(",");
+    Serial.print(runs);
+    Serial.print(",");
+    Serial.print(benchCycles[0]);
+    Serial.print(",");
+    Serial.print(median);
+    Serial.print(",");
+    Serial.print(benchCycles[runs - 1]);
+    Serial.print(",");
+    Serial.println((uint32_t)((uint64_t)median * 1000000000 / rp2040.f_cpu()));
+}
+
+// One ADSR of its own with 1s stages, timed at a point in each phase
+static void benchEnvelopePhases()
+{
+    ADSR adsr(DEFAULT_DAC_SIZE);
+    adsr.set_attack(1000000);
+    adsr.set_decay(1000000);
+    adsr.set_sustain(2000);
+    adsr.set_release(1000000);
+    benchAdsr = &adsr;
+
+    adsr.note_on();
+    uint64_t noteOn = time_us_64();
+    benchTime = noteOn + 500000;
+    benchCase("envelope", "attack", BENCH_RUNS, nullptr, benchEnvelope);
+    benchTime = noteOn + 1500000;
+    benchCase("envelope", "decay", BENCH_RUNS, nullptr, benchEnvelope);
+    benchTime = noteOn + 3000000;
+    benchCase("envelope", "sustain", BENCH_RUNS, nullptr, benchEnvelope);
+
+    adsr.note_off();
+    uint64_t noteOff = time_us_64();
+    benchTime = noteOff + 500000;
+    benchCase("envelope", "release", BENCH_RUNS, nullptr, benchEnvelope);
+    benchTime = noteOff + 2000000;
+    benchCase("envelope", "finished", BENCH_RUNS, nullptr, benchEnvelope);
+    benchAdsr = nullptr;
+}
+
+static void benchDac()
+{
+    flashSafeBegin(); // Core1 stays out of the DAC state until flashSafeEnd()
+
+    cacheDacValue(0, 2048);
+    benchCase("cacheDacValue", "unchanged", BENCH_RUNS, nullptr, benchCacheSame);
+    benchCase("cacheDacValue", "changed", BENCH_RUNS, nullptr, benchCacheChanged);
+
+    dacWrite();
+    benchCase("dacWrite", "unchanged", BENCH_RUNS, nullptr, benchDacWrite);
+    benchCase("dacWrite", "one_channel", BENCH_RUNS, benchCacheChanged, benchDacWrite);
+    benchCase("dacWrite", "all_channels", BENCH_RUNS, benchChangeAll, benchDacWrite);
+
+    flashSafeEnd();
+}
+
+static void benchEncoder()
+{
+    State savedState = currentState;
+    benchChannel = channel_selected;
+    int ch = benchChannel - 1;
+    int attackStep = getTargetValue(0, ch);
+    int decayStep = getTargetValue(1, ch);
+    int sustain = adsr_sustain[ch];
+    int releaseStep = getTargetValue(3, ch);
+    currentState = ADSR_SCREEN; // The only screen where the encoders change parameters
+
+    benchReadEncoder(0); // Take up any movement since the last pass
+    benchCase("readEncoder", "idle", BENCH_RUNS, nullptr, benchReadEncoder);
+    benchCase("readEncoder", "moving", BENCH_RUNS, benchTurnEncoder, benchReadEncoder);
+
+    // The next encoder2.update() puts the step back, resynced by setChannelParameters()
+    setChannelParameters(ch, attackStep, decayStep, sustain, releaseStep);
+    adsr_class[ch].set_attack(adsr_attack[ch]);
+    adsr_class[ch].set_decay(adsr_decay[ch]);
+    adsr_class[ch].set_sustain(adsr_sustain[ch]);
+    adsr_class[ch].set_release(adsr_release[ch]);
+    paramsVersion++;
+    currentState = savedState;
+}
+
+static void benchOled()
+{
+    benchCase("oledUpdate", "redraw", BENCH_OLED_RUNS, benchOledRedraw, benchOledUpdate);
+    benchCase("oledUpdate", "not_due", BENCH_RUNS, nullptr, benchOledUpdate);
+    benchCase("oledUpdate", "unchanged", BENCH_OLED_RUNS, benchOledDue, benchOledUpdate);
+}
+
+void runBenchmarks()
+{
+    Serial.print("# bench timer=");
+#ifdef NATIVE_HAL
+    Serial.print("steady_clock");
+#else
+    Serial.print("systick");
+#endif
+    Serial.print(" f_cpu=");
+    Serial.print(rp2040.f_cpu());
+    Serial.print(" channels=");
+    Serial.print(NUM_CHANNELS);
+    Serial.print(" dac=");
+    Serial.println(dacDriver->name());
+    Serial.println("bench,function,case,runs,min_cycles,median_cycles,max_cycles,median_ns");
+
+    benchOverhead = 0;
+    benchCase("timer", "overhead", BENCH_RUNS, nullptr, benchEmpty);
+    benchOverhead = benchCycles[BENCH_RUNS / 2];
+
+    benchEnvelopePhases();
+    benchDac();
+    benchEncoder();
+    benchOled();
+}
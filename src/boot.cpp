@@ -0,0 +1,109 @@
+#include "boot.h"
+#include "dac.h"
+#include "presets.h"
+#include "autosave.h"
+#include "encoder.h"
+#include "oled.h"
+#include "flash_safe.h"
+#include <LittleFS.h>
+
+volatile uint32_t bootTimeUs[BOOT_PHASES];
+
+const char *bootPhaseNames[BOOT_PHASES] = {
+    "setup", "gates live", "output ready", "first frame", "filesystem",
+    "state restored", "encoders", "display", "calibrated"};
+
+int bootStep = 0;
+bool bootFilesystemMounted = false;
+bool bootFormatPending = false; // The filesystem wouldn't mount, bootFilesystemService() formats it
+
+// One step per call, in dependency order: the restore needs the filesystem. None of them waits
+// on the outputs: they only read flash, and the writes are left to the services in loop().
+bool bootService()
+{
+  switch (bootStep)
+  {
+  case 0:
+  {
+    // No format from begin(), that would be a long write with the outputs running
+    LittleFSConfig config;
+    config.setAutoFormat(false);
+    LittleFS.setConfig(config);
+    bootFilesystemMounted = LittleFS.begin();
+    bootFormatPending = !bootFilesystemMounted;
+    if (bootFilesystemMounted)
+    {
+      loadDacCalibration();
+      setupPresets();
+    }
+    bootMark(BOOT_FILESYSTEM);
+    break;
+  }
+  case 1:
+    if (bootFilesystemMounted)
+    {
+      restoreAutosave();
+    }
+    bootMark(BOOT_RESTORED);
+    break;
+  case 2:
+    encoderSetup();
+    bootMark(BOOT_ENCODERS);
+    break;
+  case 3:
+    oledSetup(); // BOOT_DISPLAY is marked once the first frame is out
+    break;
+  default:
+    return true;
+  }
+  bootStep++;
+  return false;
+}
+
+// From loop() after boot: a filesystem that wouldn't mount is formatted as a flash safe step,
+// then set up as bootService() would have
+void bootFilesystemService()
+{
+  if (!bootFormatPending || !flashSafeReady())
+  {
+    return;
+  }
+  flashSafeBegin();
+  bool ok = LittleFS.format() && LittleFS.begin();
+  flashSafeEnd();
+  bootFormatPending = false;
+  if (!ok)
+  {
+    Serial.println("Filesystem: format failed, presets and autosave are off");
+    return;
+  }
+  Serial.println("Filesystem: would not mount, formatted");
+  bootFilesystemMounted = true;
+  setupPresets();
+  restoreAutosave();
+}
+
+bool bootComplete()
+{
+  return bootStep > 3;
+}
+
+void printBootProfile()
+{
+  Serial.println("Boot phases, ms since power-on:");
+  for (int i = 0; i < BOOT_PHASES; i++)
+  {
+    Serial.print("  ");
+    Serial.print(bootPhaseNames[i]);
+    Serial.print(": ");
+    if (bootTimeUs[i] == 0)
+    {
+      Serial.println("-");
+      continue;
+    }
+    Serial.print(bootTimeUs[i] / 1000);
+    Serial.print(".");
+    Serial.print((bootTimeUs[i] / 100) % 10);
+    Serial.println();
+  }
+}
@@ -3,11 +3,16 @@
 #include "config.h"
 #include "encoder_read.h"
 #include "oled.h"
+#include "dac_fifo.h"
+#include "text_format.h"
+#include "scenes.h"
 #include <adsr.h> // import class
 
 // Shared variables between cores - must be volatile
 volatile ButtonState buttonState[4] = {BUTTON_RELEASED, BUTTON_RELEASED, BUTTON_RELEASED, BUTTON_RELEASED};
 volatile bool manualTrigger[4] = {false, false, false, false};
+int manualTriggerChannel[4] = {0, 0, 0, 0}; // Channel (0-based) each button's manual trigger started
+int menuSelectPending = 0;                  // Button waiting to select a menu item on release, 0 for none
 volatile unsigned long prevDebounceTime[4] = {0, 0, 0, 0};
 volatile int lastSwitchState[4] = {HIGH, HIGH, HIGH, HIGH}; // Track last switch state for debouncing
 
@@ -67,16 +72,24 @@ bool checkEncoderButton(int encoderIndex)
     if (switchState == LOW && buttonState[encoderIndex - 1] == BUTTON_RELEASED)
     {
       buttonState[encoderIndex - 1] = BUTTON_PRESSED;
-      if (channel_selected == encoderIndex)
+      if (currentState == MENU_SCREEN)
+      {
+        // Select on release, so the first button of a double press doesn't select
+        encoderDoublePressCheck();
+        menuSelectPending = (currentState == MENU_SCREEN) ? encoderIndex : 0;
+      }
+      else if (channel_selected == buttonChannel(encoderIndex))
       {
         adsr_class[channel_selected - 1].note_on();
-        manualTrigger[channel_selected - 1] = true;
+        dacFifoInvalidate();
+        manualTrigger[encoderIndex - 1] = true;
+        manualTriggerChannel[encoderIndex - 1] = channel_selected - 1;
       }
       else
       {
         encoder_button_pressed(encoderIndex);
       }
-      oledUpdateNeeded = true;
+      uiVersion++;
       return true;
     }
     else if (switchState == HIGH && buttonState[encoderIndex - 1] == BUTTON_PRESSED)
@@ -84,9 +97,15 @@ bool checkEncoderButton(int encoderIndex)
       buttonState[encoderIndex - 1] = BUTTON_RELEASED;
       if (manualTrigger[encoderIndex - 1])
       {
-        adsr_class[encoderIndex - 1].note_off();
+        adsr_class[manualTriggerChannel[encoderIndex - 1]].note_off();
+        dacFifoInvalidate();
         manualTrigger[encoderIndex - 1] = false;
       }
+      if (menuSelectPending == encoderIndex)
+      {
+        menuSelectPending = 0;
+        menuSelect();
+      }
       return false;
     }
   }
@@ -97,31 +116,45 @@ bool checkEncoderButton(int encoderIndex)
   return false;
 }
 
+// Channel (1-based) a button selects on the current page
+int buttonChannel(int encoderIndex)
+{
+  return channel_page * 4 + encoderIndex;
+}
+
 void encoder_button_pressed(int encoderIndex)
 {
   // Prevent multiple calls - only switch if we're actually changing channels
-  if (channel_selected == encoderIndex)
+  if (channel_selected == buttonChannel(encoderIndex))
   {
     return;
   }
 
-  encoderDoublePressCheck(); // Check for double press action
+  if (encoderDoublePressCheck()) // Check for double press action
+  {
+    return; // Scene switch, the channel stays selected
+  }
+
+  selectChannel(buttonChannel(encoderIndex));
+}
 
+void selectChannel(int channel)
+{
   Serial.print("Switching from channel ");
   Serial.print(channel_selected);
   Serial.print(" to channel ");
-  Serial.println(encoderIndex);
+  Serial.println(channel);
   Serial.print("Saving current values: A=");
-  Serial.print(String(getTargetValue(0, channel_selected - 1)));
+  Serial.print(getTargetValue(0, channel_selected - 1));
   Serial.print(" D=");
-  Serial.print(String(getTargetValue(1, channel_selected - 1)));
+  Serial.print(getTargetValue(1, channel_selected - 1));
   Serial.print(" S=");
-  Serial.print(String(getTargetValue(2, channel_selected - 1)));
+  Serial.print(getTargetValue(2, channel_selected - 1));
   Serial.print(" R=");
-  Serial.println(String(getTargetValue(3, channel_selected - 1)));
+  Serial.println(getTargetValue(3, channel_selected - 1));
 
   // Switch to new channel
-  channel_selected = encoderIndex;
+  channel_selected = channel;
   int new_ch = channel_selected - 1;
 
   // Reset encoder state for all 4 parameters to sync with new channel's stored values
@@ -132,21 +165,29 @@ void encoder_button_pressed(int encoderIndex)
     setTargetValue(getTargetValue(param, new_ch), param);
   }
 
-  oledUpdateNeeded = true; // Flag to update OLED display
+  uiVersion++; // Flag to update OLED display
 }
 
-void encoderDoublePressCheck()
+bool encoderDoublePressCheck()
 {
   int pressedCount = 0;
-  String pressedButtons = "";
+  char pressedButtons[12] = ""; // "1 2 3 4 "
+  int n = 0;
   for (int i = 0; i < 4; i++)
   {
     if (buttonState[i] == BUTTON_PRESSED)
     {
       pressedCount++;
-      pressedButtons += String(i + 1) + " ";
+      n += formatInt(pressedButtons + n, sizeof(pressedButtons) - n, i + 1);
+      n += formatText(pressedButtons + n, sizeof(pressedButtons) - n, " ");
     }
   }
+  if (pressedCount == 2 && buttonState[0] == BUTTON_PRESSED && buttonState[3] == BUTTON_PRESSED && currentState != MENU_SCREEN)
+  {
+    // The outer pair switches scenes
+    sceneSwitch();
+    return true;
+  }
   if (pressedCount == 2)
   {
     // Toggle currentState
@@ -158,6 +199,7 @@ void encoderDoublePressCheck()
     else
     {
       currentState = ADSR_SCREEN;
+      menuSelectPending = 0;
       Serial.println("Exiting Menu Screen to Parameters due to double press.");
     }
 
@@ -169,4 +211,5 @@ void encoderDoublePressCheck()
     Serial.print("Not exactly two buttons pressed: ");
     Serial.println(pressedButtons);
   }
+  return false;
 }
\ No newline at end of file
@@ -1,100 +1,350 @@
-#include <SPI.h>
 #include "dac.h"
+#include "dac_driver.h"
 #include "config.h"
-
-// Define pins and constants
-const int DAC_CHANNEL_A = 0; // Channel A constant
-const int DAC_CHANNEL_B = 1; // Channel B constant
+#include "output_trace.h"
+#include "flash_safe.h"
+#include "boot.h"
+#include <LittleFS.h>
+#include <hardware/sync.h>
 
 // Operating parameters
 // const float VOLTAGE_MAX = 5.0;  // Maximum output voltage
 
 // float currentVoltage = 0.0;     // Tracks current voltage in the ramp
 
-float channelGain[4] = {0.98, 0.98, 0.98, 0.98}; // Gain for each channel, to calibrate notes over the whole range (A, B, C, D)
-float channelOffsets[4] = {0, 0, 0, 0};          // Offset integers for each channel in DAC values, to calibrate zero volts (A, B, C, D)
+const float defaultChannelGain = 0.98;  // Default gain for every channel, used when no calibration file is stored
+const float defaultChannelOffset = 0.0; // Default offset for every channel in DAC values, to calibrate zero volts
+
+// Calibration: a piecewise linear correction per channel, one point every 256 DAC codes.
+// Correcting a sample is a table lookup and an integer multiply-shift.
+int16_t dacCalibration[NUM_CHANNELS][DAC_CAL_POINTS];
+int16_t dacCalibrationLoaded[NUM_CHANNELS][DAC_CAL_POINTS]; // Loaded on core0, copied in by core1 between frames
+volatile bool dacCalibrationPending = false;
+
+// Calibration file layout
+struct DacCalibrationFile
+{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t channels;
+    uint8_t points;
+    int16_t table[NUM_CHANNELS][DAC_CAL_POINTS];
+};
+const uint32_t DAC_CAL_MAGIC = 0x4C414344; // "DCAL"
+const uint16_t DAC_CAL_VERSION = 2;
+const char *dacCalibrationPath = "/dac_cal.bin";
 
 // Stored DAC values for each channel, ready for DAC output
-int dacValues[4] = {0, 0, 0, 0};
+int dacValues[NUM_CHANNELS];
 bool dacUpdateNeeded = false; // Flag to indicate if DAC update is needed
 
+// Change tracking, so only channels that moved are sent
+int dacWrittenValues[NUM_CHANNELS]; // Last value sent per channel
+bool dacChannelDirty[NUM_CHANNELS];
+uint32_t dacLastWriteTime[NUM_CHANNELS]; // time_us_32() of the last write per channel
+uint32_t dacRefreshIntervalUs = DAC_REFRESH_INTERVAL_US;
+volatile uint32_t dacWritesIssued = 0;  // Channel writes sent to the DACs
+volatile uint32_t dacWritesSkipped = 0; // Channel writes skipped because nothing changed
+
+// Frame rate measurement
+volatile uint32_t dacFramesPerSecond = 0;
+uint32_t dacFrameCount = 0;
+uint32_t dacFrameCountStart = 0;
+
+// Longest time between two frames, and the longest after which the output had moved (a visible step)
+volatile uint32_t dacFrameGapMaxUs = 0;
+volatile uint32_t dacFrameGapMovedMaxUs = 0;
+uint32_t dacLastFrameTime = 0;
+
+// Latched output and skew measurement, requested from core0 and applied by core1 between frames
+volatile bool dacLatchedOutput = DAC_LATCHED_OUTPUT;
+bool dacLatchedApplied = false;
+volatile bool dacSkewMeasurePending = false;
+volatile uint32_t dacSkewNs[2] = {0, 0};
+volatile uint32_t dacLatencyNs[2] = {0, 0};
+volatile bool dacSkewMeasured[2] = {false, false};
+
+// Output backend, picked at build time with DAC_DRIVER
+#if DAC_DRIVER == DAC_DRIVER_MCP4728
+MCP4728Driver dacBackend;
+#elif DAC_DRIVER == DAC_DRIVER_PWM
+PWMDacDriver dacBackend;
+#elif DAC_DRIVER == DAC_DRIVER_MOCK
+MockDacDriver dacBackend;
+#else
+MCP4922Driver dacBackend;
+#endif
+DacDriver *dacDriver = &dacBackend;
+
+// Engine sample period, set from the driver's measured frame time
+uint32_t dacSamplePeriodUs = 0;
+
+// Correction points from a gain and offset, for the defaults
+void setDacCalibrationLinear(int channel, float gain, float offset)
+{
+    for (int i = 0; i < DAC_CAL_POINTS; i++)
+    {
+        dacCalibration[channel][i] = (int16_t)lroundf((i << DAC_CAL_SHIFT) * gain + offset);
+    }
+    dacChannelDirty[channel] = true;
+}
+
+// Read the correction table stored in flash. Runs on core0 at boot, core1 picks it up in dacApplyPending().
+bool loadDacCalibration()
+{
+    File file = LittleFS.open(dacCalibrationPath, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    DacCalibrationFile data;
+    bool valid = file.size() == sizeof(data) &&
+                 file.read((uint8_t *)&data, sizeof(data)) == sizeof(data) &&
+                 data.magic == DAC_CAL_MAGIC && data.version == DAC_CAL_VERSION &&
+                 data.channels == NUM_CHANNELS && data.points == DAC_CAL_POINTS;
+    file.close();
+
+    for (int ch = 0; valid && ch < NUM_CHANNELS; ch++)
+    {
+        for (int i = 0; i < DAC_CAL_POINTS; i++)
+        {
+            if (data.table[ch][i] < -4096 || data.table[ch][i] > 8191)
+            {
+                valid = false;
+            }
+        }
+    }
+    if (!valid)
+    {
+        Serial.println("DAC calibration file invalid, using defaults");
+        return false;
+    }
+
+    memcpy(dacCalibrationLoaded, data.table, sizeof(dacCalibrationLoaded));
+    dacCalibrationPending = true;
+    Serial.println("DAC calibration loaded");
+    return true;
+}
+
+// Store the current correction table to flash
+bool saveDacCalibration()
+{
+    DacCalibrationFile data;
+    data.magic = DAC_CAL_MAGIC;
+    data.version = DAC_CAL_VERSION;
+    data.channels = NUM_CHANNELS;
+    data.points = DAC_CAL_POINTS;
+    memcpy(data.table, dacCalibration, sizeof(data.table));
+
+    // A bench operation, so it doesn't wait for steady outputs, but core1 stops between frames
+    flashSafeBegin();
+    File file = LittleFS.open(dacCalibrationPath, "w");
+    bool ok = file && file.write((const uint8_t *)&data, sizeof(data)) == sizeof(data);
+    if (file)
+    {
+        file.close();
+    }
+    flashSafeEnd();
+    return ok;
+}
+
 void setupDAC()
 {
             Serial.println("DAC initialising"); // Add this for debugging
 
-    pinMode(DAC_CS_PIN, OUTPUT);
-    digitalWrite(DAC_CS_PIN, HIGH); // Deselect DAC initially
-    pinMode(DAC_CS_PIN2, OUTPUT);
-    digitalWrite(DAC_CS_PIN2, HIGH); // Deselect second DAC initially
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        setDacCalibrationLinear(ch, defaultChannelGain, defaultChannelOffset);
+        dacWrittenValues[ch] = -1;
+        dacChannelDirty[ch] = true;
+    }
+
+    if (!dacDriver->begin())
+    {
+        Serial.println("DAC driver failed to start");
+    }
+
+    // Leave 25% headroom over a full frame so envelope maths fits alongside the transfer
+    dacSamplePeriodUs = dacDriver->frame_time_us() + dacDriver->frame_time_us() / 4;
+    Serial.print("DAC driver: ");
+    Serial.print(dacDriver->name());
+    Serial.print(", frame time us: ");
+    Serial.println(dacDriver->frame_time_us());
+
+    dacFrameCountStart = time_us_32();
 
         Serial.println("DAC initialised"); // Add this for debugging
 
 }
 
-// Send value to MCP4922
-void dacWrite()
+// Count frames, and update the frames per second once a second
+static inline void countDacFrame()
 {
-    for (int dac = 0; dac < 2; dac++)
+    dacFrameCount++;
+    uint32_t now = time_us_32();
+    if (now - dacFrameCountStart >= 1000000)
     {
-        int cs_pin = (dac == 0) ? DAC_CS_PIN : DAC_CS_PIN2;
-        for (int ch = 0; ch < 2; ch++)
+        dacFramesPerSecond = dacFrameCount;
+        dacFrameCount = 0;
+        dacFrameCountStart = now;
+    }
+}
+
+// Write the frame once in each output mode, timing when every channel updates
+static void measureDacSkew(const uint16_t *frame)
+{
+    uint32_t cyclesPerUs = rp2040.f_cpu() / 1000000;
+    for (int mode = 0; mode < 2; mode++)
+    {
+        uint32_t cycles[NUM_CHANNELS];
+        bool latched = (mode == 1);
+        dacSkewMeasured[mode] = dacDriver->set_latched(latched) &&
+                                dacDriver->measure_update_cycles(frame, NUM_CHANNELS, cycles) == NUM_CHANNELS;
+        if (!dacSkewMeasured[mode])
         {
-            // Separate messages for first and second DAC
-            int value;
-            if (dac == 0)
-            {
-                value = dacValues[ch];
+            continue;
+        }
 
-                if (ch == 0)
-                {
-                   // Serial.print(" Value: ");
-                   // Serial.println(value);
-                }
-            }
-            else
-            {
-                value = dacValues[ch + 2];
-            }
+        uint32_t first = cycles[0];
+        uint32_t last = cycles[0];
+        for (int i = 1; i < NUM_CHANNELS; i++)
+        {
+            first = min(first, cycles[i]);
+            last = max(last, cycles[i]);
+        }
+        dacSkewNs[mode] = (last - first) * 1000 / cyclesPerUs;
+        dacLatencyNs[mode] = last * 1000 / cyclesPerUs;
+    }
+    dacDriver->set_latched(dacLatchedApplied);
+}
+
+// Core1, between frames and never from the FIFO's timer interrupt: a failed mode change
+// prints, and the skew measurement busy-polls the driver.
+void dacApplyPending()
+{
+    if (dacCalibrationPending)
+    {
+        memcpy(dacCalibration, dacCalibrationLoaded, sizeof(dacCalibration));
+        dacCalibrationPending = false;
+    }
+
+    if (dacLatchedOutput == dacLatchedApplied && !dacSkewMeasurePending)
+    {
+        return;
+    }
 
-            value = constrain(value, 0, 4095); // Ensure 12-bit range
-
-            byte command = (ch == DAC_CHANNEL_A) ? 0x30 : 0xB0;
-            // 0x30 = 0011 0000: channel A, buffered, gain=1, active
-            // 0xB0 = 1011 0000: channel B, buffered, gain=1, active
-
-            SPI.beginTransaction(SPISettings(20000000, MSBFIRST, SPI_MODE0));
-            digitalWrite(cs_pin, LOW);
-            SPI.transfer(command | ((value >> 8) & 0x0F)); // High byte with command
-            SPI.transfer(value & 0xFF);                    // Low byte
-            digitalWrite(cs_pin, HIGH);
-            SPI.endTransaction();
-
-            /*
-            Serial.print("DAC ");
-            Serial.print(dac +1);
-            Serial.print(" Channel ");
-            Serial.print((ch == DAC_CHANNEL_A) ? "A" : "B");
-            Serial.print(" Value: ");
-            Serial.print(value);
-            Serial.print(" at micros: ");
-            Serial.print(micros());
-            Serial.println();
-            */
+    // Keep the timer interrupt off the driver while it is reconfigured
+    bool latchFailed = false;
+    uint32_t irq = save_and_disable_interrupts();
+    if (dacLatchedOutput != dacLatchedApplied)
+    {
+        dacLatchedApplied = dacLatchedOutput;
+        latchFailed = !dacDriver->set_latched(dacLatchedApplied);
+    }
+    if (dacSkewMeasurePending)
+    {
+        // Rewrite the last frame sent, so the measurement does not move the outputs
+        uint16_t frame[NUM_CHANNELS];
+        for (int i = 0; i < NUM_CHANNELS; i++)
+        {
+            frame[i] = max(dacWrittenValues[i], 0);
         }
+        measureDacSkew(frame);
+        dacSkewMeasurePending = false;
+    }
+    restore_interrupts(irq);
+
+    if (latchFailed)
+    {
+        Serial.println("DAC: latched output not supported by this driver");
     }
 }
 
+// Send the cached values to the DAC driver
+// Only channels whose value changed are sent, plus any channel not refreshed for dacRefreshIntervalUs
+void dacWrite()
+{
+    dacApplyPending();
+    uint16_t frame[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++)
+    {
+        frame[i] = constrain(dacValues[i], 0, 4095);
+    }
+    dacWriteFrame(frame);
+}
+
+// Send a frame of calibrated values, also called by the output FIFO's timer.
+// Interrupt safe: pending changes wait for dacApplyPending().
+void dacWriteFrame(const uint16_t *values)
+{
+    uint32_t now = time_us_32();
+    uint32_t channelMask = 0;
+    int sendCount = 0;
+    bool moved = false;
+    uint16_t frame[NUM_CHANNELS];
+    for (int i = 0; i < NUM_CHANNELS; i++)
+    {
+        frame[i] = values[i];
+        moved |= frame[i] != dacWrittenValues[i];
+        if (dacChannelDirty[i] || frame[i] != dacWrittenValues[i] || now - dacLastWriteTime[i] >= dacRefreshIntervalUs)
+        {
+            channelMask |= 1u << i;
+            sendCount++;
+            dacChannelDirty[i] = false;
+            dacLastWriteTime[i] = now;
+            dacWrittenValues[i] = frame[i];
+        }
+    }
+    traceOutputFrame(frame);
+
+    uint32_t gap = now - dacLastFrameTime;
+    dacLastFrameTime = now;
+    if (gap > dacFrameGapMaxUs)
+    {
+        dacFrameGapMaxUs = gap;
+    }
+    if (moved && gap > dacFrameGapMovedMaxUs)
+    {
+        dacFrameGapMovedMaxUs = gap;
+    }
+
+    dacWritesIssued += sendCount;
+    dacWritesSkipped += NUM_CHANNELS - sendCount;
+    dacUpdateNeeded = false;
+    countDacFrame();
+
+    if (sendCount > 0)
+    {
+        dacDriver->write_frame(frame, NUM_CHANNELS, channelMask);
+    }
+    bootMark(BOOT_FIRST_FRAME);
+}
+
+// Apply calibration: interpolate between the two correction points either side of the value
+int calibrateDacValue(int channel, int value)
+{
+    value = constrain(value, 0, 4095);
+    const int16_t *points = dacCalibration[channel];
+    int segment = value >> DAC_CAL_SHIFT;
+    int fraction = value & ((1 << DAC_CAL_SHIFT) - 1);
+    return points[segment] + (((points[segment + 1] - points[segment]) * fraction) >> DAC_CAL_SHIFT);
+}
+
 // Set specific voltage (5V reference)
-void cacheDacValue(int channel, float value)
+void cacheDacValue(int channel, int value)
 {
-    // Apply gain and offset for calibration
-    value = (value * channelGain[channel]) + channelOffsets[channel];
+    value = calibrateDacValue(channel, value);
 
     // Store the current 12 bit value to the appropriate channel
     // instead of writing to the DAC directly
     dacValues[channel] = value;
 
-    dacUpdateNeeded = true; // Set flag to indicate DAC update is needed
+    if (dacValues[channel] != dacWrittenValues[channel])
+    {
+        dacChannelDirty[channel] = true;
+        dacUpdateNeeded = true; // Set flag to indicate DAC update is needed
+    }
 }
 
 void printDacValues()
@@ -117,7 +367,7 @@ void printDacValues()
     //  Serial.print(String(cursorPos[i]));
     int i = 0;
     Serial.print(" | DAC: ");
-    Serial.print(String(dacValues[i]));
+    Serial.print(dacValues[i]);
     // if (i < 3)
     //  {
     //      Serial.print(", ");
@@ -130,3 +380,43 @@ void printDacValues()
     // }
     //}
 }
+
+void printDacFrameRate()
+{
+    Serial.print("DAC frames/s: ");
+    Serial.print(dacFramesPerSecond);
+    Serial.print(" writes issued: ");
+    Serial.print(dacWritesIssued);
+    Serial.print(" skipped: ");
+    Serial.println(dacWritesSkipped);
+}
+
+// Ask core1 to time one frame in each output mode, results in dacSkewNs once dacSkewMeasured is set
+void requestDacSkewMeasurement()
+{
+    dacSkewMeasurePending = true;
+}
+
+void printDacSkew()
+{
+    const char *modes[2] = {"immediate", "latched"};
+    Serial.print("DAC skew ns:");
+    for (int mode = 0; mode < 2; mode++)
+    {
+        Serial.print(" ");
+        Serial.print(modes[mode]);
+        Serial.print("=");
+        if (dacSkewMeasured[mode])
+        {
+            Serial.print(dacSkewNs[mode]);
+            Serial.print(" (last update ");
+            Serial.print(dacLatencyNs[mode]);
+            Serial.print(")");
+        }
+        else
+        {
+            Serial.print("n/a");
+        }
+    }
+    Serial.println(dacLatchedOutput ? " [latched]" : " [immediate]");
+}
@@ -0,0 +1,267 @@
+#include "dac_fifo.h"
+#include "dac.h"
+#include "config.h"
+#include <pico/time.h>
+#include <hardware/sync.h>
+
+volatile int dacFifoDepth = DAC_FIFO_DEPTH;
+volatile uint32_t dacFifoUnderruns = 0;
+volatile uint32_t dacFifoFlushes = 0;
+volatile uint32_t dacFifoQueueLatencyUs = 0;
+volatile uint32_t dacFifoTriggerLatencyUs = 0;
+volatile uint32_t dacFifoWriteCycles = 0;
+
+#if DAC_FIFO_DEPTH > 0
+
+struct DacFifoFrame
+{
+    uint32_t renderedAt; // time_us_32() when it was queued
+    uint32_t generation; // dacFifoGeneration it was rendered in
+    uint16_t values[NUM_CHANNELS];
+};
+
+DacFifoFrame dacFifo[DAC_FIFO_DEPTH];
+volatile uint32_t dacFifoRead = 0;  // Frames sent, free running
+volatile uint32_t dacFifoWrite = 0; // Frames queued, free running
+volatile uint32_t dacFifoTicks = 0; // Timer ticks so far
+uint64_t dacFifoStartUs = 0;        // Timer start, tick n fires at dacFifoStartUs + n * dacFifoPeriodUs
+uint32_t dacFifoPeriodUs = 0;
+
+// Gate changes, flagged by core0 and handled by core1 before the next render
+volatile bool dacFifoInvalidatePending = false;
+volatile uint32_t dacFifoInvalidateTime = 0;
+volatile uint32_t dacFifoGeneration = 0;
+volatile bool dacFifoTriggerPending = false; // Waiting for the first frame rendered after a gate change
+
+alarm_pool_t *dacFifoAlarmPool = nullptr;
+repeating_timer_t dacFifoTimer;
+
+// Runs on core1 every dacFifoPeriodUs: send the oldest frame
+static bool dacFifoTimerCallback(repeating_timer_t *rt)
+{
+    uint32_t startCycles = rp2040.getCycleCount();
+    dacFifoTicks++;
+    if (dacFifoRead == dacFifoWrite)
+    {
+        dacFifoUnderruns++; // The outputs hold their last value
+        return true;
+    }
+
+    const DacFifoFrame &frame = dacFifo[dacFifoRead % DAC_FIFO_DEPTH];
+    dacWriteFrame(frame.values);
+
+    uint32_t now = time_us_32();
+    dacFifoQueueLatencyUs += ((int32_t)(now - frame.renderedAt) - (int32_t)dacFifoQueueLatencyUs) / 8;
+    if (dacFifoTriggerPending && frame.generation == dacFifoGeneration)
+    {
+        dacFifoTriggerLatencyUs = now - dacFifoInvalidateTime;
+        dacFifoTriggerPending = false;
+    }
+    dacFifoRead++;
+
+    dacFifoWriteCycles += ((int32_t)(rp2040.getCycleCount() - startCycles) - (int32_t)dacFifoWriteCycles) / 16;
+    return true;
+}
+
+// Worst of a few renders and writes of the current output, in µs
+static uint32_t measureDacFifoFrameUs()
+{
+    uint32_t cyclesPerUs = rp2040.f_cpu() / 1000000;
+    uint32_t worst = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        uint32_t startCycles = rp2040.getCycleCount();
+        int env_values[NUM_CHANNELS];
+        adsr_class.render(env_values, time_us_64());
+        uint16_t values[NUM_CHANNELS];
+        for (int ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            values[ch] = constrain(calibrateDacValue(ch, env_values[ch]), 0, 4095);
+        }
+        dacWriteFrame(values);
+        worst = max(worst, rp2040.getCycleCount() - startCycles);
+    }
+    return (worst + cyclesPerUs - 1) / cyclesPerUs;
+}
+
+// Call on core1 after setupDAC(). The alarm pool is created here so its interrupt runs on core1.
+void setupDacFifo()
+{
+    // The driver's frame time only counts the bus. Core1 also renders a frame and takes the
+    // interrupt every tick, so the period must fit all three with half of core1 to spare.
+    uint32_t frameUs = measureDacFifoFrameUs();
+    uint32_t periodUs = max(dacSamplePeriodUs, 2 * (frameUs + DAC_FIFO_IRQ_US));
+
+    // And never below DAC_FIFO_MIN_PERIOD_US: this caps the output rate, even for a driver and
+    // render that could go faster
+    if (periodUs < DAC_FIFO_MIN_PERIOD_US)
+    {
+        Serial.print("DAC FIFO: period raised to the minimum, capped at frames/s: ");
+        Serial.println(1000000 / DAC_FIFO_MIN_PERIOD_US);
+        periodUs = DAC_FIFO_MIN_PERIOD_US;
+    }
+    dacFifoPeriodUs = periodUs;
+    dacSamplePeriodUs = periodUs; // The engine now runs at the timer's rate
+    Serial.print("DAC FIFO: render and write us: ");
+    Serial.print(frameUs);
+    Serial.print(", period us: ");
+    Serial.println(dacFifoPeriodUs);
+
+    dacFifoAlarmPool = alarm_pool_create_with_unused_hardware_alarm(4);
+    dacFifoStartUs = time_us_64();
+    if (!alarm_pool_add_repeating_timer_us(dacFifoAlarmPool, -(int64_t)dacFifoPeriodUs, dacFifoTimerCallback, nullptr, &dacFifoTimer))
+    {
+        Serial.println("DAC FIFO: output timer failed to start");
+    }
+}
+
+bool dacFifoService()
+{
+    dacApplyPending(); // Not safe in the timer interrupt
+
+    // Drop everything queued so the next frame out is rendered after the gate change
+    if (dacFifoInvalidatePending)
+    {
+        uint32_t irq = save_and_disable_interrupts();
+        dacFifoWrite = dacFifoRead;
+        restore_interrupts(irq);
+        dacFifoInvalidatePending = false;
+        dacFifoGeneration++;
+        dacFifoTriggerPending = true;
+        dacFifoFlushes++;
+    }
+
+    uint32_t irq = save_and_disable_interrupts();
+    uint32_t queued = dacFifoWrite - dacFifoRead;
+    uint32_t ticks = dacFifoTicks;
+    restore_interrupts(irq);
+    if ((int)queued >= dacFifoDepth)
+    {
+        return false;
+    }
+
+    // Render for the tick this frame will go out on
+    uint64_t frameTime = dacFifoStartUs + (uint64_t)(ticks + queued + 1) * dacFifoPeriodUs;
+    int env_values[NUM_CHANNELS];
+    adsr_class.render(env_values, frameTime);
+
+    DacFifoFrame &frame = dacFifo[dacFifoWrite % DAC_FIFO_DEPTH];
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        frame.values[ch] = constrain(calibrateDacValue(ch, env_values[ch]), 0, 4095);
+    }
+    frame.generation = dacFifoGeneration;
+    frame.renderedAt = time_us_32();
+
+    // A gate change while rendering makes this frame stale, it is dropped on the next call
+    if (!dacFifoInvalidatePending)
+    {
+        dacFifoWrite++;
+    }
+    return true;
+}
+
+void dacFifoInvalidate()
+{
+    dacFifoInvalidateTime = time_us_32();
+    dacFifoInvalidatePending = true;
+}
+
+// Core1, between frames. The timer is stopped, not masked: a masked repeating timer sends
+// every tick it missed back to back once unmasked, thousands after a flash erase.
+// Restarting rebases the ticks on now, so the next tick is a period away and the render
+// times follow. The outputs were steady while held, so the queued frames still apply.
+void dacFifoHold(bool hold)
+{
+    if (hold)
+    {
+        cancel_repeating_timer(&dacFifoTimer);
+        return;
+    }
+    dacFifoStartUs = time_us_64() - (uint64_t)dacFifoTicks * dacFifoPeriodUs;
+    alarm_pool_add_repeating_timer_us(dacFifoAlarmPool, -(int64_t)dacFifoPeriodUs, dacFifoTimerCallback, nullptr, &dacFifoTimer);
+}
+
+void printDacFifo()
+{
+    Serial.print("DAC FIFO depth: ");
+    Serial.print(dacFifoDepth);
+    Serial.print(" underruns: ");
+    Serial.print(dacFifoUnderruns);
+    Serial.print(" flushes: ");
+    Serial.print(dacFifoFlushes);
+    Serial.print(" queue latency us: ");
+    Serial.print(dacFifoQueueLatencyUs);
+    Serial.print(" trigger latency us: ");
+    Serial.println(dacFifoTriggerLatencyUs);
+}
+
+// Runs on core0: for each depth, let the FIFO settle, then fake gate changes and time them
+void runDacFifoBenchmark()
+{
+    const int triggers = 50;
+    int savedDepth = dacFifoDepth;
+
+    Serial.println("DAC FIFO benchmark: depth, queue latency us, trigger latency us avg/max, underruns/s");
+    for (int depth = 1; depth <= DAC_FIFO_DEPTH; depth++)
+    {
+        dacFifoDepth = depth;
+        delay(100);
+
+        uint32_t underruns = dacFifoUnderruns;
+        uint32_t start = millis();
+        uint32_t triggerSum = 0;
+        uint32_t triggerMax = 0;
+        for (int i = 0; i < triggers; i++)
+        {
+            dacFifoInvalidate();
+            delay(20);
+            triggerSum += dacFifoTriggerLatencyUs;
+            triggerMax = max(triggerMax, (uint32_t)dacFifoTriggerLatencyUs);
+        }
+        uint32_t elapsed = millis() - start;
+
+        Serial.print(depth);
+        Serial.print(", ");
+        Serial.print(dacFifoQueueLatencyUs);
+        Serial.print(", ");
+        Serial.print(triggerSum / triggers);
+        Serial.print("/");
+        Serial.print(triggerMax);
+        Serial.print(", ");
+        Serial.println((dacFifoUnderruns - underruns) * 1000 / elapsed);
+    }
+    dacFifoDepth = savedDepth;
+}
+
+#else
+
+// Lockstep build: loop1() renders and writes each frame itself
+
+void setupDacFifo()
+{
+}
+
+bool dacFifoService()
+{
+    return false;
+}
+
+void dacFifoInvalidate()
+{
+}
+
+void dacFifoHold(bool hold)
+{
+}
+
+void printDacFifo()
+{
+}
+
+void runDacFifoBenchmark()
+{
+    Serial.println("DAC FIFO benchmark needs DAC_FIFO_DEPTH > 0");
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include <Wire.h>
+#include <Adafruit_MCP4728.h>
+#include "dac_driver.h"
+#include "config.h"
+
+// The MCP4728 sits on its own I2C bus so core1 never shares Wire with the OLED on core0
+Adafruit_MCP4728 mcp4728;
+
+bool MCP4728Driver::begin()
+{
+    Wire1.setSDA(MCP4728_SDA_PIN);
+    Wire1.setSCL(MCP4728_SCL_PIN);
+    Wire1.begin();
+    Wire1.setClock(400000);
+    if (!mcp4728.begin(MCP4728_I2CADDR_DEFAULT, &Wire1))
+    {
+        Serial.println("DAC: MCP4728 not found");
+        return false;
+    }
+
+    uint16_t zeros[4] = {0, 0, 0, 0};
+    uint32_t start = time_us_32();
+    write_frame(zeros, 4);
+    _frame_time_us = time_us_32() - start;
+    return true;
+}
+
+// Fast write always updates all four channels, so the channel mask is ignored
+void MCP4728Driver::write_frame(const uint16_t *values, int n, uint32_t channel_mask)
+{
+    uint16_t v[4] = {0, 0, 0, 0};
+    for (int channel = 0; channel < n && channel < 4; channel++)
+    {
+        v[channel] = constrain(values[channel], 0, 4095);
+    }
+    mcp4728.fastWrite(v[0], v[1], v[2], v[3]);
+}
@@ -0,0 +1,513 @@
+#include <SPI.h>
+#include "dac.h"
+#include "dac_driver.h"
+#include "config.h"
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+
+// Define pins and constants
+const int DAC_CHANNEL_A = 0; // Channel A constant
+const int DAC_CHANNEL_B = 1; // Channel B constant
+
+const int DAC_CHIPS = NUM_CHANNELS / 2; // One MCP4922 per two channels
+
+// MCP4922 command word: channel select, buffered, gain=1, active, then the 12 bit value
+// 0x30 = 0011 0000: channel A, buffered, gain=1, active
+// 0xB0 = 1011 0000: channel B, buffered, gain=1, active
+static inline uint16_t dacCommand(int ch, int value)
+{
+    value = constrain(value, 0, 4095); // Ensure 12-bit range
+    return ((ch == DAC_CHANNEL_A) ? 0x3000 : 0xB000) | value;
+}
+
+// MCP23S17 writes, hardware address 0, sequential addressing so both ports go in one write
+const uint32_t EXPANDER_WRITE = 0x40;
+const uint32_t EXPANDER_IODIRA = 0x00;
+const uint32_t EXPANDER_OLATA = 0x14;
+
+static inline uint32_t expanderWrite(uint32_t reg, uint16_t portsAB)
+{
+    return (EXPANDER_WRITE << 24) | (reg << 16) | ((portsAB & 0xFF) << 8) | (portsAB >> 8);
+}
+
+static inline bool csOnExpander(int cs)
+{
+    return cs >= EXPANDER_PIN_BASE;
+}
+
+// One bus transaction: the native pin to pull low (-1 for none), the bits to send,
+// and the channel whose DAC register it loads (-1 for expander writes and LDAC pulses)
+struct DacTransaction
+{
+    int8_t cs;
+    uint8_t bits;
+    int8_t channel;
+    uint32_t data;
+};
+
+// Worst case per channel: release the expander, select on the expander, the DAC word.
+// Plus a final release and the LDAC pulse.
+const int DAC_MAX_TRANSACTIONS = 3 * NUM_CHANNELS + 2;
+DacTransaction dacTransactions[DAC_MAX_TRANSACTIONS];
+
+bool dacUsesExpander = false;
+
+// All native CS pins, the expander CS and LDAC are driven from one PIO OUT mapping that spans from the
+// lowest to the highest pin. Only those pins are switched to the PIO, the pins in between are left untouched.
+int dacCsBase = 0;
+int dacCsSpan = 0;
+uint32_t dacCsIdle = 0;  // every CS high
+uint32_t dacLdacBit = 0; // LDAC within the span, 0 if LDAC is not wired
+uint32_t dacOutIdle = 0; // OUT pattern between transactions: CS high, LDAC high when latched
+
+// Two FIFO words per transaction, shifted out MSB first:
+//   control: [pin pattern while shifting][bit count - 1, 5 bits][pin pattern after, the rising CS loads the DAC]
+//   data:    the bits to send, left aligned
+// SET pins are SCK (bit 0) and MOSI (bit 1), so each data bit is two SET instructions.
+// The pattern for after is parked in the ISR while the data word is in the OSR.
+const int DAC_PIO_LENGTH = 17;
+uint16_t dacPioInstructions[DAC_PIO_LENGTH];
+pio_program_t dacPioProgram = {dacPioInstructions, DAC_PIO_LENGTH, -1};
+
+PIO dacPio = pio1;
+int dacPioSm = -1;
+uint dacPioOffset = 0;
+int dacDmaChannel = -1;
+
+const int DAC_PIO_CLKDIV = 3;        // >= 22ns per instruction, within MCP4922 timing
+const int DAC_PIO_SKEW_SLOWDOWN = 8; // Skew is timed with the PIO this much slower so polling sees every edge
+
+// Double buffered frames: one is built while the other is being drained by DMA
+uint32_t dacFrame[2][2 * DAC_MAX_TRANSACTIONS];
+int dacFrameIndex = 0;
+
+// Skew measurement: when each transaction pulled its pin low and released it, in cycles from the frame start
+uint32_t dacAssertCycles[DAC_MAX_TRANSACTIONS];
+uint32_t dacReleaseCycles[DAC_MAX_TRANSACTIONS];
+bool dacTimingTransactions = false;
+
+// Pin changes seen while polling a PIO frame
+struct DacPinEvent
+{
+    uint32_t cycles;
+    uint32_t levels;
+};
+const int DAC_MAX_PIN_EVENTS = 2 * DAC_MAX_TRANSACTIONS + 2;
+DacPinEvent dacPinEvents[DAC_MAX_PIN_EVENTS];
+
+static void buildDacPioProgram(int lowDelay)
+{
+    uint16_t *p = dacPioInstructions;
+    p[0] = pio_encode_pull(false, true);                // wait for the next control word
+    p[1] = pio_encode_out(pio_pins, dacCsSpan);         // select
+    p[2] = pio_encode_out(pio_y, 5);                    // bit count - 1
+    p[3] = pio_encode_mov(pio_isr, pio_osr);            // park the pattern for after
+    p[4] = pio_encode_pull(false, true);                // data word
+    p[5] = pio_encode_out(pio_x, 1);                    // bitloop: next data bit
+    p[6] = pio_encode_jmp_not_x(11);
+    p[7] = pio_encode_set(pio_pins, 2) | pio_encode_delay(lowDelay); // MOSI=1, SCK=0
+    p[8] = pio_encode_set(pio_pins, 3);                 // MOSI=1, SCK=1
+    p[9] = pio_encode_jmp_y_dec(5);
+    p[10] = pio_encode_jmp(14);
+    p[11] = pio_encode_set(pio_pins, 0) | pio_encode_delay(lowDelay); // MOSI=0, SCK=0
+    p[12] = pio_encode_set(pio_pins, 1);                // MOSI=0, SCK=1
+    p[13] = pio_encode_jmp_y_dec(5);
+    p[14] = pio_encode_set(pio_pins, 0);                // SCK idle low
+    p[15] = pio_encode_mov(pio_osr, pio_isr);
+    p[16] = pio_encode_out(pio_pins, dacCsSpan);        // deselect, DAC register loads
+}
+
+static inline int csPin(int chip)
+{
+    return csOnExpander(DAC_CS_MAP[chip]) ? EXPANDER_CS_PIN : DAC_CS_MAP[chip];
+}
+
+// Work out the OUT span from the chip select map and LDAC
+static void setupDacCsPins()
+{
+    int low = (DAC_LDAC_PIN >= 0) ? DAC_LDAC_PIN : 31;
+    int high = (DAC_LDAC_PIN >= 0) ? DAC_LDAC_PIN : 0;
+    for (int chip = 0; chip < DAC_CHIPS; chip++)
+    {
+        dacUsesExpander |= csOnExpander(DAC_CS_MAP[chip]);
+        low = min(low, csPin(chip));
+        high = max(high, csPin(chip));
+    }
+    dacCsBase = low;
+    dacCsSpan = high - low + 1;
+
+    dacCsIdle = 0;
+    for (int chip = 0; chip < DAC_CHIPS; chip++)
+    {
+        dacCsIdle |= 1u << (csPin(chip) - dacCsBase);
+    }
+    dacLdacBit = (DAC_LDAC_PIN >= 0) ? 1u << (DAC_LDAC_PIN - dacCsBase) : 0;
+    dacOutIdle = dacCsIdle; // LDAC low: outputs follow CS
+}
+
+static inline uint32_t dacOutPinMask()
+{
+    return (dacCsIdle | dacLdacBit) << dacCsBase;
+}
+
+static inline void addTransaction(int &count, int cs, int bits, uint32_t data, int channel = -1)
+{
+    dacTransactions[count++] = {(int8_t)cs, (uint8_t)bits, (int8_t)channel, data};
+}
+
+// Build the transactions for a set of channels. expanderSelected tracks which expander pin is low.
+static int buildDacTransactions(const uint16_t *values, int n, uint32_t channel_mask, bool ldacPulse)
+{
+    int count = 0;
+    int expanderSelected = -1;
+    for (int channel = 0; channel < n && channel < NUM_CHANNELS; channel++)
+    {
+        if (!(channel_mask & (1u << channel)))
+        {
+            continue;
+        }
+        int cs = DAC_CS_MAP[channel / 2];
+        uint16_t command = dacCommand(channel % 2, values[channel]);
+
+        if (!csOnExpander(cs))
+        {
+            if (expanderSelected >= 0)
+            {
+                addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_OLATA, 0xFFFF));
+                expanderSelected = -1;
+            }
+            addTransaction(count, cs, 16, command, channel);
+        }
+        else
+        {
+            int pin = cs - EXPANDER_PIN_BASE;
+            // Same chip again needs its CS to go high in between. Moving to a different chip raises the
+            // old CS and lowers the new one in the same write.
+            if (expanderSelected == pin)
+            {
+                addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_OLATA, 0xFFFF));
+            }
+            addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_OLATA, (uint16_t)~(1u << pin)));
+            addTransaction(count, -1, 16, command, channel);
+            expanderSelected = pin;
+        }
+    }
+    if (expanderSelected >= 0)
+    {
+        addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_OLATA, 0xFFFF));
+    }
+    // One clock with LDAC low moves every loaded register to the outputs together
+    if (ldacPulse && count > 0)
+    {
+        addTransaction(count, DAC_LDAC_PIN, 1, 0);
+    }
+    return count;
+}
+
+static inline void dacPioWords(const DacTransaction &t, uint32_t *words)
+{
+    uint32_t select = (t.cs >= 0) ? (dacOutIdle & ~(1u << (t.cs - dacCsBase))) : dacOutIdle;
+    words[0] = (select << (32 - dacCsSpan)) |
+               ((uint32_t)(t.bits - 1) << (27 - dacCsSpan)) |
+               (dacOutIdle << (27 - 2 * dacCsSpan));
+    words[1] = t.data << (32 - t.bits);
+}
+
+// Finished once the FIFO is empty and the state machine is back waiting for a control word
+static inline bool dacPioIdle()
+{
+    return !dma_channel_is_busy(dacDmaChannel) && pio_sm_is_tx_fifo_empty(dacPio, dacPioSm) &&
+           pio_sm_get_pc(dacPio, dacPioSm) == dacPioOffset;
+}
+
+bool MCP4922Driver::_begin_pio()
+{
+    if (dacCsSpan > 8)
+    {
+        Serial.println("DAC: CS pins more than 8 apart, using SPI");
+        return false;
+    }
+
+    dacPioSm = pio_claim_unused_sm(dacPio, false);
+    if (dacPioSm < 0)
+    {
+        dacPio = pio0;
+        dacPioSm = pio_claim_unused_sm(dacPio, false);
+    }
+    // The MCP23S17 needs 45ns SCK low time, so add a cycle when it is on the bus
+    buildDacPioProgram(dacUsesExpander ? 1 : 0);
+    if (dacPioSm < 0 || !pio_can_add_program(dacPio, &dacPioProgram))
+    {
+        Serial.println("DAC: no free PIO state machine, using SPI");
+        return false;
+    }
+    uint offset = pio_add_program(dacPio, &dacPioProgram);
+    dacPioOffset = offset;
+
+    uint32_t outMask = dacOutPinMask();
+    uint32_t busMask = (1u << DAC_SCK_PIN) | (1u << DAC_MOSI_PIN);
+    for (int pin = 0; pin < 30; pin++)
+    {
+        if ((outMask | busMask) & (1u << pin))
+        {
+            pio_gpio_init(dacPio, pin);
+        }
+    }
+    pio_sm_set_pins_with_mask(dacPio, dacPioSm, dacOutIdle << dacCsBase, outMask | busMask); // CS high, LDAC, SCK and MOSI low
+    pio_sm_set_pindirs_with_mask(dacPio, dacPioSm, outMask | busMask, outMask | busMask);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset, offset + DAC_PIO_LENGTH - 1);
+    sm_config_set_out_pins(&c, dacCsBase, dacCsSpan);
+    sm_config_set_set_pins(&c, DAC_SCK_PIN, 2);
+    sm_config_set_out_shift(&c, false, false, 32); // MSB first, explicit pull
+    sm_config_set_in_shift(&c, false, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);  // 8 words, four transactions
+    sm_config_set_clkdiv(&c, DAC_PIO_CLKDIV);
+    pio_sm_init(dacPio, dacPioSm, offset, &c);
+    pio_sm_set_enabled(dacPio, dacPioSm, true);
+
+    dacDmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config d = dma_channel_get_default_config(dacDmaChannel);
+    channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+    channel_config_set_read_increment(&d, true);
+    channel_config_set_write_increment(&d, false);
+    channel_config_set_dreq(&d, pio_get_dreq(dacPio, dacPioSm, true));
+    dma_channel_configure(dacDmaChannel, &d, &dacPio->txf[dacPioSm], dacFrame[0], 0, false);
+
+    return true;
+}
+
+bool MCP4922Driver::begin()
+{
+    setupDacCsPins();
+
+#if DAC_PIO_OUTPUT
+    _use_pio = _begin_pio();
+#endif
+    if (!_use_pio)
+    {
+        SPI.begin();
+        for (int pin = 0; pin < 30; pin++)
+        {
+            if (dacOutPinMask() & (1u << pin))
+            {
+                pinMode(pin, OUTPUT);
+                digitalWrite(pin, ((dacOutIdle << dacCsBase) & (1u << pin)) ? HIGH : LOW); // Deselect initially
+            }
+        }
+    }
+
+    // Expander outputs high first, then switch them to outputs so no DAC sees a CS glitch
+    if (dacUsesExpander)
+    {
+        int count = 0;
+        addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_OLATA, 0xFFFF));
+        addTransaction(count, EXPANDER_CS_PIN, 32, expanderWrite(EXPANDER_IODIRA, 0x0000));
+        _send(count);
+    }
+
+    // Time one full frame of zeros, start to last CS rising edge
+    uint16_t zeros[NUM_CHANNELS] = {0};
+    uint32_t start = rp2040.getCycleCount();
+    write_frame(zeros, NUM_CHANNELS);
+    if (_use_pio)
+    {
+        while (!dacPioIdle())
+        {
+        }
+    }
+    _frame_time_us = (rp2040.getCycleCount() - start) / (rp2040.f_cpu() / 1000000) + 1;
+    return true;
+}
+
+// LDAC high holds the outputs until the pulse at the end of each frame. Without LDAC wired the
+// frame still goes out as one PIO burst, so the skew is one DAC word per channel.
+bool MCP4922Driver::set_latched(bool latched)
+{
+    _latched = latched;
+    dacOutIdle = dacCsIdle | (latched ? dacLdacBit : 0);
+    if (!_use_pio && DAC_LDAC_PIN >= 0)
+    {
+        digitalWrite(DAC_LDAC_PIN, latched ? HIGH : LOW);
+    }
+    return true;
+}
+
+// Channels 1 and 2 are on the first DAC, 3 and 4 on the second, and so on through DAC_CS_MAP
+void MCP4922Driver::write_frame(const uint16_t *values, int n, uint32_t channel_mask)
+{
+    int count = buildDacTransactions(values, n, channel_mask, _latched && dacLdacBit);
+    if (count > 0)
+    {
+        _send(count);
+    }
+}
+
+void MCP4922Driver::_send(int count)
+{
+    if (_use_pio)
+    {
+        _send_pio(count);
+    }
+    else
+    {
+        _send_spi(count);
+    }
+}
+
+void MCP4922Driver::_send_pio(int count)
+{
+    // Build the frame while the previous one is still being shifted out
+    uint32_t *frame = dacFrame[dacFrameIndex];
+    for (int i = 0; i < count; i++)
+    {
+        dacPioWords(dacTransactions[i], &frame[2 * i]);
+    }
+
+    // Only waits if the PIO FIFO still holds a whole frame
+    dma_channel_wait_for_finish_blocking(dacDmaChannel);
+    dma_channel_transfer_from_buffer_now(dacDmaChannel, frame, 2 * count);
+    dacFrameIndex ^= 1;
+}
+
+void MCP4922Driver::_send_spi(int count)
+{
+    uint32_t start = rp2040.getCycleCount();
+    for (int i = 0; i < count; i++)
+    {
+        const DacTransaction &t = dacTransactions[i];
+
+        // MCP23S17 is limited to 10MHz
+        SPI.beginTransaction(SPISettings(t.cs == EXPANDER_CS_PIN ? 10000000 : 20000000, MSBFIRST, SPI_MODE0));
+        if (t.cs >= 0)
+        {
+            digitalWrite(t.cs, LOW);
+        }
+        if (dacTimingTransactions)
+        {
+            dacAssertCycles[i] = rp2040.getCycleCount() - start;
+        }
+        for (int shift = t.bits - 8; shift >= 0; shift -= 8)
+        {
+            SPI.transfer((t.data >> shift) & 0xFF);
+        }
+        if (t.cs >= 0)
+        {
+            digitalWrite(t.cs, HIGH);
+        }
+        if (dacTimingTransactions)
+        {
+            dacReleaseCycles[i] = rp2040.getCycleCount() - start;
+        }
+        SPI.endTransaction();
+    }
+}
+
+// Send a frame with the PIO slowed down and poll the pins, then match the edges to the transactions.
+// Transactions with no native pin (DAC words behind the expander) have no edges and aren't timed.
+void MCP4922Driver::_time_pio(int count)
+{
+    while (!dacPioIdle())
+    {
+    }
+    pio_sm_set_clkdiv(dacPio, dacPioSm, DAC_PIO_CLKDIV * DAC_PIO_SKEW_SLOWDOWN);
+
+    uint32_t pinMask = dacOutPinMask();
+    uint32_t timeout = (_frame_time_us + 10) * 2 * DAC_PIO_SKEW_SLOWDOWN * (rp2040.f_cpu() / 1000000);
+    int events = 0;
+    dacPinEvents[events++] = {0, gpio_get_all() & pinMask};
+
+    uint32_t start = rp2040.getCycleCount();
+    _send_pio(count);
+    uint32_t now = start;
+    while (now - start < timeout && events < DAC_MAX_PIN_EVENTS)
+    {
+        uint32_t levels = gpio_get_all() & pinMask;
+        now = rp2040.getCycleCount();
+        if (levels != dacPinEvents[events - 1].levels)
+        {
+            dacPinEvents[events++] = {now - start, levels};
+        }
+        else if (dacPioIdle())
+        {
+            break;
+        }
+    }
+    pio_sm_set_clkdiv(dacPio, dacPioSm, DAC_PIO_CLKDIV);
+
+    int event = 1;
+    for (int i = 0; i < count; i++)
+    {
+        const DacTransaction &t = dacTransactions[i];
+        dacAssertCycles[i] = dacReleaseCycles[i] = 0;
+        if (t.cs < 0)
+        {
+            continue;
+        }
+        uint32_t bit = 1u << t.cs;
+        for (bool released = false; event < events && !released; event++)
+        {
+            uint32_t was = dacPinEvents[event - 1].levels & bit;
+            uint32_t is = dacPinEvents[event].levels & bit;
+            if (was && !is)
+            {
+                dacAssertCycles[i] = dacPinEvents[event].cycles / DAC_PIO_SKEW_SLOWDOWN;
+            }
+            else if (!was && is && dacAssertCycles[i])
+            {
+                dacReleaseCycles[i] = dacPinEvents[event].cycles / DAC_PIO_SKEW_SLOWDOWN;
+                released = true;
+            }
+        }
+    }
+}
+
+// A channel's output changes when LDAC falls in latched mode, otherwise when its CS rises.
+// For DACs behind the expander that is the end of the next expander write.
+int MCP4922Driver::measure_update_cycles(const uint16_t *values, int n, uint32_t *cycles)
+{
+    bool ldacPulse = _latched && dacLdacBit;
+    int count = buildDacTransactions(values, n, DAC_ALL_CHANNELS, ldacPulse);
+
+    if (_use_pio)
+    {
+        _time_pio(count);
+    }
+    else
+    {
+        dacTimingTransactions = true;
+        _send_spi(count);
+        dacTimingTransactions = false;
+    }
+
+    int timed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const DacTransaction &t = dacTransactions[i];
+        if (t.channel < 0)
+        {
+            continue;
+        }
+        uint32_t update = 0;
+        if (ldacPulse)
+        {
+            update = dacAssertCycles[count - 1];
+        }
+        else if (t.cs >= 0)
+        {
+            update = dacReleaseCycles[i];
+        }
+        else
+        {
+            for (int j = i + 1; j < count && !update; j++)
+            {
+                update = dacReleaseCycles[j];
+            }
+        }
+        cycles[t.channel] = update;
+        timed++;
+    }
+    return timed;
+}
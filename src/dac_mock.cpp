@@ -0,0 +1,18 @@
+#include "dac_driver.h"
+
+bool MockDacDriver::begin()
+{
+    _frame_count = 0;
+    return true;
+}
+
+void MockDacDriver::write_frame(const uint16_t *values, int n, uint32_t channel_mask)
+{
+    uint16_t *frame = _frames[_frame_count % DAC_MOCK_FRAMES];
+    for (int channel = 0; channel < DAC_MOCK_CHANNELS; channel++)
+    {
+        frame[channel] = (channel < n) ? values[channel] : 0;
+    }
+    _masks[_frame_count % DAC_MOCK_FRAMES] = channel_mask;
+    _frame_count++;
+}
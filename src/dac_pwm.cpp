@@ -0,0 +1,54 @@
+#include <hardware/pwm.h>
+#include <hardware/clocks.h>
+#include "dac_driver.h"
+#include "config.h"
+
+const uint16_t PWM_WRAP = 4095; // 12 bit levels
+
+// Two pins on the same slice and channel share one compare register, the last level written drives both
+constexpr bool pwmPinsShareChannel()
+{
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = i + 1; j < 4; j++)
+        {
+            if (PWM_OUT_PINS[i] % 16 == PWM_OUT_PINS[j] % 16)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+static_assert(!pwmPinsShareChannel(), "PWM_OUT_PINS: two pins on the same PWM slice and channel");
+
+// 12 bit PWM, about 30kHz at 125MHz, so each output needs an RC filter
+bool PWMDacDriver::begin()
+{
+    for (int channel = 0; channel < 4; channel++)
+    {
+        gpio_set_function(PWM_OUT_PINS[channel], GPIO_FUNC_PWM);
+        uint slice = pwm_gpio_to_slice_num(PWM_OUT_PINS[channel]);
+        pwm_set_clkdiv(slice, 1.0f);
+        pwm_set_wrap(slice, PWM_WRAP);
+        pwm_set_gpio_level(PWM_OUT_PINS[channel], 0);
+        pwm_set_enabled(slice, true);
+    }
+
+    // Writing a level is a register store, but the new level only takes effect at the next wrap.
+    // One PWM period, (wrap + 1) / clk_sys at divider 1, rounded up.
+    uint32_t clockHz = clock_get_hz(clk_sys);
+    _frame_time_us = (uint32_t)(((uint64_t)(PWM_WRAP + 1) * 1000000 + clockHz - 1) / clockHz);
+    return true;
+}
+
+void PWMDacDriver::write_frame(const uint16_t *values, int n, uint32_t channel_mask)
+{
+    for (int channel = 0; channel < n && channel < 4; channel++)
+    {
+        if (channel_mask & (1u << channel))
+        {
+            pwm_set_gpio_level(PWM_OUT_PINS[channel], constrain(values[channel], 0, 4095));
+        }
+    }
+}
@@ -4,21 +4,17 @@
 //#include "EncoderReader.h"
 #include "encoder.h"
 #include "config.h"
+#include "boot.h"
 
-// declare two encoders that will actually be reading the same pins:
-// one will measure the phase sizes and compensate for differences, while
-// the other will work as if the phase sizes were perfectly uniform
+// One PIO state machine per encoder, so four of the eight are left free
+// (the DAC output uses one of them)
 PicoEncoder encoder1;
-PicoEncoder encoder1_non_calibrated;
 // Second encoder
 PicoEncoder encoder2;
-PicoEncoder encoder2_non_calibrated;
 // Third encoder
 PicoEncoder encoder3;
-PicoEncoder encoder3_non_calibrated;
 // Fourth encoder
 PicoEncoder encoder4;
-PicoEncoder encoder4_non_calibrated;
 
 // keep track of current time
 uint period_start_us;
@@ -43,15 +39,10 @@ void encoderSetup()
   //Serial.begin(115200);
 
   // Initialise encoders
-  // use the same pins for both the calibrated and non-calibrated encoders
   encoder1.begin(encoder_pinA);
-  encoder1_non_calibrated.begin(encoder_pinA);
   encoder2.begin(encoder2_pinA);
-  encoder2_non_calibrated.begin(encoder2_pinA);
   encoder3.begin(encoder3_pinA);
-  encoder3_non_calibrated.begin(encoder3_pinA);
   encoder4.begin(encoder4_pinA);
-  encoder4_non_calibrated.begin(encoder4_pinA);
   
   // Configure encoder switch pin as input with pullup
   //pinMode(encoder_switch, INPUT_PULLUP);
@@ -63,43 +54,18 @@ void encoderSetup()
 
 void encoderUpdate()
 {
-  static int calibrationCounter = 0;
-  static bool initialCalibrationDone = false;
-  
-  // During startup (first 100 calls), do intensive calibration
-  if (!initialCalibrationDone) {
-    while ((int)(time_us_32() - period_start_us) < 10000)
-      encoder1.autoCalibratePhases();
-    period_start_us += 10000;
-
-    calibrationCounter++;
-    if (calibrationCounter >= 100) {
-      initialCalibrationDone = true;
-      calibrationCounter = 0; // Reset counter for maintenance calibration
-    }
-  } else {
-    // After startup, do maintenance calibration much less frequently
-    // Only do intensive calibration every 50th call (~once every 0.5 seconds at 10ms calls)
-    if (calibrationCounter % 50 == 0) {
-      while ((int)(time_us_32() - period_start_us) < 10000)
-        encoder1.autoCalibratePhases();
-      period_start_us += 10000;
-    } else {
-      // Just do a quick calibration step without blocking
-      encoder1.autoCalibratePhases();
-      period_start_us = time_us_32(); // Reset timer to avoid accumulation
-    }
-    calibrationCounter++;
+  // One calibration step per call. It used to busy-wait 10ms a call for the first second,
+  // which held up everything else in setup and loop, and then 10ms every 50 calls.
+  encoder1.autoCalibratePhases();
+  if (encoder1.autoCalibrationDone())
+  {
+    bootMark(BOOT_CALIBRATED);
   }
 
   encoder1.update();
-  encoder1_non_calibrated.update();
   encoder2.update();
-  encoder2_non_calibrated.update();
   encoder3.update();
-  encoder3_non_calibrated.update();
   encoder4.update();
-  encoder4_non_calibrated.update();
 
   // Print values at regular intervals without blocking
   if (millis() - lastPrintMillis >= printInterval) {
@@ -113,23 +79,21 @@ void encoderUpdate()
 
     if (encoderSerialPrint) {
         Serial.print("Encoder1 - speed: ");
-        Serial.print(String(encoder1.speed));
+        Serial.print(encoder1.speed);
         Serial.print(", position: ");
-        Serial.print(String(encoder1.position));
+        Serial.print(encoder1.position);
         Serial.print(", step: ");
-        Serial.print(String(encoder1.step));
+        Serial.print(encoder1.step);
         if (encoder1.autoCalibrationDone()) {
             Serial.print(", phases: 0x");
-            Serial.print(String(encoder1.getPhases(), HEX));
+            Serial.print(encoder1.getPhases(), HEX);
         }
-        Serial.print(", non calibrated speed: ");
-        Serial.print(String(encoder1_non_calibrated.speed));
         Serial.print(" | Encoder2 - speed: ");
-        Serial.print(String(encoder2.speed));
+        Serial.print(encoder2.speed);
         Serial.print(", position: ");
-        Serial.print(String(encoder2.position));
+        Serial.print(encoder2.position);
         Serial.print(", step: ");
-        Serial.print(String(encoder2.step));
+        Serial.print(encoder2.step);
         Serial.println();
     }
   }
@@ -2,6 +2,8 @@
 #include "Arduino.h"
 #include "encoder.h"
 #include "config.h"
+#include "text_format.h"
+#include "log_time.h"
 #include <adsr.h> // import class
 
 // CALIBRATION
@@ -13,39 +15,26 @@ int lowerSpeedThreshold = 300;
 // Variables to track the potentiometer and target value
 uint16_t encoderValue = 0;
 
-const int time_upper = 1000;
+const int time_upper = LOG_TIME_STEPS;
 const int sustain_upper = 100;
 
-const long long adsr_attack_min = 1000;  // minimum time in µs
-const long long adsr_decay_min = 1000;   // minimum time in µs
-const int adsr_sustain_min = 1;          // minimum sustain level
-const long long adsr_release_min = 1000; // minimum time in µs
-
-// Global arrays for encoder state
-int initTargetValue[4][4] = {{-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}};      // Initial target position for each encoder, per channel
-int16_t lastEncoderValue[4][4] = {{-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}, {-1, -1, -1, -1}}; // Previous potentiometer reading
-int16_t targetValue[4][4];
-/* = {{(int16_t)(time_upper * log((double)adsr_attack / adsr_attack_min) / log((double)adsr_attack_max / adsr_attack_min)),
-                          (int16_t)(time_upper * log((double)adsr_decay / adsr_decay_min) / log((double)adsr_decay_max / adsr_decay_min)),
-                          (int16_t)((double)adsr_sustain / adsr_sustain_max * sustain_upper),
-                          (int16_t)(time_upper * log((double)adsr_release / adsr_release_min) / log((double)adsr_release_max / adsr_release_min))},
-                          {(int16_t)(time_upper * log((double)adsr_attack / adsr_attack_min) / log((double)adsr_attack_max / adsr_attack_min)),
-                          (int16_t)(time_upper * log((double)adsr_decay / adsr_decay_min) / log((double)adsr_decay_max / adsr_decay_min)),
-                          (int16_t)((double)adsr_sustain / adsr_sustain_max * sustain_upper),
-                          (int16_t)(time_upper * log((double)adsr_release / adsr_release_min) / log((double)adsr_release_max / adsr_release_min))},
-                          {(int16_t)(time_upper * log((double)adsr_attack / adsr_attack_min) / log((double)adsr_attack_max / adsr_attack_min)),
-                          (int16_t)(time_upper * log((double)adsr_decay / adsr_decay_min) / log((double)adsr_decay_max / adsr_decay_min)),
-                          (int16_t)((double)adsr_sustain / adsr_sustain_max * sustain_upper),
-                          (int16_t)(time_upper * log((double)adsr_release / adsr_release_min) / log((double)adsr_release_max / adsr_release_min))},
-                          {(int16_t)(time_upper * log((double)adsr_attack / adsr_attack_min) / log((double)adsr_attack_max / adsr_attack_min)),
-                          (int16_t)(time_upper * log((double)adsr_decay / adsr_decay_min) / log((double)adsr_decay_max / adsr_decay_min)),
-                          (int16_t)((double)adsr_sustain / adsr_sustain_max * sustain_upper),
-                          (int16_t)(time_upper * log((double)adsr_release / adsr_release_min) / log((double)adsr_release_max / adsr_release_min))}}; // Current target value for each encoder
-*/
+const long long adsr_attack_min = LOG_TIME_MIN_US;  // minimum time in µs
+const long long adsr_decay_min = LOG_TIME_MIN_US;   // minimum time in µs
+const int adsr_sustain_min = 1;                     // minimum sustain level
+const long long adsr_release_min = LOG_TIME_MIN_US; // minimum time in µs
+
+// Global arrays for encoder state, [parameter][channel]
+int initTargetValue[4][NUM_CHANNELS];      // Initial target position for each encoder, per channel
+int16_t lastEncoderValue[4][NUM_CHANNELS]; // Previous potentiometer reading, -1 until the first reading
+int16_t targetValue[4][NUM_CHANNELS];      // Current target value for each encoder, per channel
 int16_t encoderChange[4] = {0, 0, 0, 0}; // How much the potentiometer moved
 
 // Set to true to print the potentiometer values
-bool serialPrintEncoder = true;
+bool serialPrintEncoder = false;
+
+// Per-call cost of readEncoder() in CPU cycles (smoothed), for idle and moving encoders
+volatile uint32_t readEncoderIdleCycles = 0;
+volatile uint32_t readEncoderMovingCycles = 0;
 
 const int CENTER_OFFSET = 32768; // Half of a 16-bit integer range
 
@@ -55,55 +44,64 @@ int direction = 0; // Direction of the last change
 
 // volatile bool arrayNewTargetValue; // Flag to indicate if the target value has changed, only for arrays
 
-const long long adsr_attack_max = 100000000;   // time in µs
-const long long adsr_decay_max = 100000000;    // time in µs
-const int adsr_sustain_max = 4095;             // sustain level -> from 0 to DACSIZE-1
-const long long adsr_release_max = 1000000000; // time in µs
+const long long adsr_attack_max = ATTACK_DECAY_MAX_US; // time in µs
+const long long adsr_decay_max = ATTACK_DECAY_MAX_US;  // time in µs
+const int adsr_sustain_max = 4095;                     // sustain level -> from 0 to DACSIZE-1
+const long long adsr_release_max = RELEASE_MAX_US;     // time in µs
+
+// Encoder step -> time in µs
+static inline unsigned long stepToTime(const LogTimeTable &table, int step)
+{
+  return logTimeFromStep(table, step);
+}
+
+// Time in µs -> encoder step, the highest step that doesn't exceed the time
+static inline int timeToStep(const LogTimeTable &table, unsigned long time)
+{
+  return logTimeToStep(table, time);
+}
 
+// The encoder targets come from setChannelParameters() (defaults, presets, autosave), this only
+// starts the encoder tracking afresh
 void setupEncoderRead()
 {
-  // Initialise all 4 parameter positions for this channel from current ADSR globals
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < NUM_CHANNELS; i++)
   {
-    targetValue[0][i] = (int16_t)(time_upper * log((double)adsr_attack[i] / adsr_attack_min) / log((double)adsr_attack_max / adsr_attack_min));
-    targetValue[1][i] = (int16_t)(time_upper * log((double)adsr_decay[i] / adsr_decay_min) / log((double)adsr_decay_max / adsr_decay_min));
-    targetValue[2][i] = (int16_t)((double)adsr_sustain[i] / adsr_sustain_max * sustain_upper);
-    targetValue[3][i] = (int16_t)(time_upper * log((double)adsr_release[i] / adsr_release_min) / log((double)adsr_release_max / adsr_release_min));
+    for (int param = 0; param < 4; param++)
+    {
+      initTargetValue[param][i] = -1;
+      lastEncoderValue[param][i] = -1;
+    }
   }
 }
 
+// Smoothed cycle count for one readEncoder() call
+static inline void recordReadEncoderCost(uint32_t startCycles, bool moving)
+{
+  uint32_t cycles = rp2040.getCycleCount() - startCycles;
+  if (moving)
+    readEncoderMovingCycles += ((int32_t)cycles - (int32_t)readEncoderMovingCycles) / 8;
+  else
+    readEncoderIdleCycles += ((int32_t)cycles - (int32_t)readEncoderIdleCycles) / 8;
+}
+
 int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int channel)
 {
+  uint32_t startCycles = rp2040.getCycleCount();
+
   // Get index for arrays (encoderId 1 -> index 0, encoderId 2 -> index 1)
   int idx = encoderId - 1;
   if (idx < 0 || idx > 3)
     idx = 0; // Default to first encoder
 
   int ch = channel - 1;
-  if (ch < 0 || ch > 3)
+  if (ch < 0 || ch >= NUM_CHANNELS)
     ch = 0; // Default to first channel
 
-  // Set range based on encoder ID
-  if (encoderId == 3) // Sustain
-  {
-    lowerRange = 0;
-    upperRange = sustain_upper;
-  }
-  else // Attack, Decay, Release
-  {
-    lowerRange = 0;
-    upperRange = time_upper;
-  }
-
   // Get speed and position based on encoder ID
   int speed;
   int position, step;
-  if (encoderId == 1)
-  {
-    getEncoder1Speed(&speed);
-    getEncoder1Position(&position, &step);
-  }
-  else if (encoderId == 2)
+  if (encoderId == 2)
   {
     getEncoder2Speed(&speed);
     getEncoder2Position(&position, &step);
@@ -120,95 +118,80 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
   }
   else
   {
-    // Default to encoder 1
+    // Encoder 1, and default
     getEncoder1Speed(&speed);
     getEncoder1Position(&position, &step);
   }
 
-  // Center the step value in a large range to avoid negative values
-  int centeredStep = step + CENTER_OFFSET;
-  int encoderValue = (centeredStep / 4);
-
   // Rolling average for speed detection using existing speed value
+  // Kept as a running total so the update is the same cost whether or not the encoder moved
   const int speedSamples = 25;                    // Number of samples for rolling average
   static int speedHistory[4][speedSamples] = {0}; // Recent speed values per encoder
   static int speedIndex[4] = {0};                 // Current position in circular buffer per encoder
-  static bool speedInitialised[4] = {false};      // Track initialization per encoder
-
-  const int gainThreshold = lowerSpeedThreshold; // Threshold for allowing gain (based on speed values we see)
-  static bool allowGain[4] = {false};            // Flag if encoder is moving fast enough per encoder
-
-  // Initialise on first run
-  if (!speedInitialised[idx])
-  {
-    speedInitialised[idx] = true;
-    allowGain[idx] = false; // Start conservative
-  }
+  static int speedTotal[4] = {0};                 // Sum of speedHistory per encoder
 
   // Use the existing speed value (absolute value to handle negative speeds)
   int currentSpeed = abs(speed);
-
-  // Update rolling average
+  speedTotal[idx] += currentSpeed - speedHistory[idx][speedIndex[idx]];
   speedHistory[idx][speedIndex[idx]] = currentSpeed;
-  speedIndex[idx] = (speedIndex[idx] + 1) % speedSamples;
+  if (++speedIndex[idx] >= speedSamples)
+    speedIndex[idx] = 0;
 
-  // Calculate rolling average
-  int totalSpeed = 0;
-  for (int i = 0; i < speedSamples; i++)
+  // Center the step value in a large range to avoid negative values
+  int centeredStep = step + CENTER_OFFSET;
+  int encoderValue = (centeredStep / 4);
+
+  // Nothing moved, nothing to recalculate
+  if (encoderValue == lastEncoderValue[idx][ch])
   {
-    totalSpeed += speedHistory[idx][i];
+    recordReadEncoderCost(startCycles, false);
+    return targetValue[idx][ch];
   }
-  int averageSpeed = totalSpeed / speedSamples;
+
+  // Set range based on encoder ID
+  if (encoderId == 3) // Sustain
+  {
+    lowerRange = 0;
+    upperRange = sustain_upper;
+  }
+  else // Attack, Decay, Release
+  {
+    lowerRange = 0;
+    upperRange = time_upper;
+  }
+
+  int averageSpeed = speedTotal[idx] / speedSamples;
 
   // Allow gain if rolling average is above threshold
-  allowGain[idx] = (averageSpeed >= gainThreshold);
+  const int gainThreshold = lowerSpeedThreshold; // Threshold for allowing gain (based on speed values we see)
+  bool allowGain = (averageSpeed >= gainThreshold);
 
   // Calculate GAIN based on speed
   int gain = 1; // initialise gain variable
-  if ((averageSpeed > upperSpeedThreshold || averageSpeed < (upperSpeedThreshold * -1)) && allowGain[idx])
+  if (averageSpeed > upperSpeedThreshold && allowGain)
   {
     gain = gainMax; // Set gain to maximum if speed is high
   }
-  else if ((averageSpeed > lowerSpeedThreshold || averageSpeed < (lowerSpeedThreshold * -1)) && allowGain[idx])
+  else if (averageSpeed > lowerSpeedThreshold && allowGain)
   {
-    // Create a logarithmic gain based on speed - higher speeds get exponentially more gain
-    float normalisedSpeed = (float)(abs(averageSpeed) - lowerSpeedThreshold) / (upperSpeedThreshold - lowerSpeedThreshold);
-    normalisedSpeed = constrain(normalisedSpeed, 0.0, 1.0); // Ensure it's between 0 and 1
-
-    // Apply logarithmic curve: gain = 1 + (gainMax-1) * (normalisedSpeed^2)
+    // Quadratic gain curve: gain = 1 + (gainMax-1) * (normalisedSpeed^2), in integers
     // This gives gentle increases at low speeds, dramatic increases at high speeds
-    float gainCurve = normalisedSpeed * normalisedSpeed; // Quadratic curve (similar effect to log)
-    gain = 1 + (gainMax - 1) * gainCurve;
+    long speedAboveThreshold = averageSpeed - lowerSpeedThreshold;
+    long speedRange = upperSpeedThreshold - lowerSpeedThreshold;
+    gain = 1 + (int)((gainMax - 1) * speedAboveThreshold * speedAboveThreshold / (speedRange * speedRange));
   }
   else
   {
     gain = 1; // Minimum gain when speed is 0
   }
 
-  /*
-  // Debug printing
-  static unsigned long lastModePrintTime = 0;
-  if (millis() - lastModePrintTime > 100)
-  {
-    Serial.print(" | speed: ");
-    Serial.print(String(speed));
-    Serial.print(" | currentSpeed: ");
-    Serial.print(String(currentSpeed));
-    Serial.print(" | avgSpeed: ");
-    Serial.print(String(averageSpeed));
-    Serial.print(" | allowGain: ");
-    Serial.print(String(allowGain));
-    Serial.println();
-
-    lastModePrintTime = millis();
-  }*/
-
   // First reading
   if (lastEncoderValue[idx][ch] == -1)
   {
     lastEncoderValue[idx][ch] = encoderValue; // No additional offset
     initTargetValue[idx][ch] = targetValue[idx][ch];
 
+    recordReadEncoderCost(startCycles, false);
     return targetValue[idx][ch]; // Skip first adjustment cycle
   }
 
@@ -234,10 +217,8 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
   {
     unsigned long current = (encoderId == 1 ? adsr_attack[ch] : encoderId == 2 ? adsr_decay[ch]
                                                                                : adsr_release[ch]);
-    double ratio = (double)adsr_attack_max / adsr_attack_min;
-    double log_ratio = log(ratio);
-    double base_delta_d = upperRange * log(1 + 10000.0 / current) / log_ratio;
-    int base_delta = (int)base_delta_d;
+    // Steps needed to move at least 10ms from the current time
+    int base_delta = timeToStep(attackDecayTimeTable, current + 10000) - timeToStep(attackDecayTimeTable, current);
     int max_delta = upperRange; // Allow full range for quick movement to max
     int sign = (encoderChange[idx] > 0 ? 1 : -1);
     if (abs(encoderChange[idx]) < base_delta && encoderChange[idx] != 0)
@@ -258,16 +239,21 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
   // Store the unquantized target value for next iteration's reference
   int unquantizedTargetValue = targetValue[idx][ch];
 
+  unsigned long previousAttack = adsr_attack[ch];
+  unsigned long previousDecay = adsr_decay[ch];
+  int previousSustain = adsr_sustain[ch];
+  unsigned long previousRelease = adsr_release[ch];
+
   switch (encoderId)
   {
   case 1:
     targetValue[0][ch] = constrain(targetValue[0][ch], lowerRange, upperRange);
-    adsr_attack[ch] = (unsigned long)(adsr_attack_min * pow((double)adsr_attack_max / adsr_attack_min, (double)targetValue[0][ch] / upperRange));
+    adsr_attack[ch] = stepToTime(attackDecayTimeTable, targetValue[0][ch]);
     adsr_class[ch].set_attack(adsr_attack[ch]);
     break;
   case 2:
     targetValue[1][ch] = constrain(targetValue[1][ch], lowerRange, upperRange);
-    adsr_decay[ch] = (unsigned long)(adsr_decay_min * pow((double)adsr_decay_max / adsr_decay_min, (double)targetValue[1][ch] / upperRange));
+    adsr_decay[ch] = stepToTime(attackDecayTimeTable, targetValue[1][ch]);
     adsr_class[ch].set_decay(adsr_decay[ch]);
     break;
   case 3:
@@ -277,7 +263,7 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
     break;
   case 4:
     targetValue[3][ch] = constrain(targetValue[3][ch], lowerRange, upperRange);
-    adsr_release[ch] = (unsigned long)(adsr_release_min * pow((double)adsr_release_max / adsr_release_min, (double)targetValue[3][ch] / upperRange));
+    adsr_release[ch] = stepToTime(releaseTimeTable, targetValue[3][ch]);
     adsr_class[ch].set_release(adsr_release[ch]);
     break;
   default:
@@ -285,6 +271,13 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
     break;
   }
 
+  // Redraw only if the value moved, not when the encoder turns against a limit
+  if (adsr_attack[ch] != previousAttack || adsr_decay[ch] != previousDecay ||
+      adsr_sustain[ch] != previousSustain || adsr_release[ch] != previousRelease)
+  {
+    paramsVersion++;
+  }
+
   const long WRAP_THRESHOLD = 10000;
 
   // Constrain to range
@@ -325,67 +318,26 @@ int readEncoder(int lowerRange, int upperRange, int gainMax, int encoderId, int
     initTargetValue[idx][ch] = ((long)lowerRange);
   }
 
-  if (encoderChange[idx] != 0)
-  { /*
-     Serial.print("Enc_");
-     Serial.print(encoderId);
-     Serial.print(": targetValues: Attack= ");
-     Serial.print(String(targetValue[0][ch]));
-     Serial.print(" Decay= ");
-     Serial.print(String(targetValue[1][ch]));
-     Serial.print(" Sustain= ");
-     Serial.print(String(targetValue[2][ch]));
-     Serial.print(" Release= ");
-     Serial.print(String(targetValue[3][ch]));
-     // Serial.print(" | initTargetValue = ");
-     // Serial.print(String(initTargetValue[idx]));
-     // Serial.print(" | encoderChange = ");
-     // Serial.print(String(encoderChange[idx]));
-     // Serial.print(" | gain = ");
-     // Serial.print(String(gain));
-     // Serial.print(" | currentChannel = ");
-     // Serial.print(String(currentChannel));
-     Serial.println();
- */
-
-    // Display all values of all channels
-    Serial.print("Enc_");
-    Serial.print(encoderId);
-    Serial.print(": ADSR Values - Ch1(A,D,S,R)=(");
-    Serial.print(String(adsr_attack[0]));
-    Serial.print(",");
-    Serial.print(String(adsr_decay[0]));
-    Serial.print(",");
-    Serial.print(String(adsr_sustain[0]));
-    Serial.print(",");
-    Serial.println(String(adsr_release[0]));
-    Serial.print(") Ch2(A,D,S,R)=(");
-    Serial.print(String(adsr_attack[1]));
-    Serial.print(",");
-    Serial.print(String(adsr_decay[1]));
-    Serial.print(",");
-    Serial.print(String(adsr_sustain[1]));
-    Serial.print(",");
-    Serial.println(String(adsr_release[1]));
-    Serial.print(") Ch3(A,D,S,R)=(");
-    Serial.print(String(adsr_attack[2]));
-    Serial.print(",");
-    Serial.print(String(adsr_decay[2]));
-    Serial.print(",");
-    Serial.print(String(adsr_sustain[2]));
-    Serial.print(",");
-    Serial.println(String(adsr_release[2]));
-    Serial.print(") Ch4(A,D,S,R)=(");
-    Serial.print(String(adsr_attack[3]));
-    Serial.print(",");
-    Serial.print(String(adsr_decay[3]));
-    Serial.print(",");
-    Serial.print(String(adsr_sustain[3]));
-    Serial.print(",");
-    Serial.print(String(adsr_release[3]));
-    Serial.println(")");
+  if (serialPrintEncoder && encoderChange[idx] != 0)
+  {
+    // Display the values of the channel that changed, e.g. "Enc_1: Ch1 A=12.3ms D=250ms S=50% R=1.20s"
+    char line[64];
+    int n = formatText(line, sizeof(line), "Enc_");
+    n += formatInt(line + n, sizeof(line) - n, encoderId);
+    n += formatText(line + n, sizeof(line) - n, ": Ch");
+    n += formatInt(line + n, sizeof(line) - n, ch + 1);
+    n += formatText(line + n, sizeof(line) - n, " A=");
+    n += formatDuration(line + n, sizeof(line) - n, adsr_attack[ch]);
+    n += formatText(line + n, sizeof(line) - n, " D=");
+    n += formatDuration(line + n, sizeof(line) - n, adsr_decay[ch]);
+    n += formatText(line + n, sizeof(line) - n, " S=");
+    n += formatPercent(line + n, sizeof(line) - n, adsr_sustain[ch], 4095, 0);
+    n += formatText(line + n, sizeof(line) - n, "% R=");
+    formatDuration(line + n, sizeof(line) - n, adsr_release[ch]);
+    Serial.println(line);
   }
 
+  recordReadEncoderCost(startCycles, true);
   return targetValue[idx][ch];
 }
 
@@ -398,4 +350,66 @@ void setTargetValue(int newTargetValue, int parameter)
 int getTargetValue(int parameter, int channel)
 {
   return targetValue[parameter][channel]; // Default to encoder 1
-}
\ No newline at end of file
+}
+
+// Set a whole channel at once, e.g. from a preset. Times are encoder steps (0 to time_upper) on the
+// log-time tables, sustain is the level. Only the globals and encoder targets change here, the
+// ADSR instances are updated by the caller.
+void setChannelParameters(int channel, int attackStep, int decayStep, int sustain, int releaseStep)
+{
+  targetValue[0][channel] = constrain(attackStep, 0, time_upper);
+  targetValue[1][channel] = constrain(decayStep, 0, time_upper);
+  targetValue[3][channel] = constrain(releaseStep, 0, time_upper);
+  adsr_attack[channel] = stepToTime(attackDecayTimeTable, targetValue[0][channel]);
+  adsr_decay[channel] = stepToTime(attackDecayTimeTable, targetValue[1][channel]);
+  adsr_release[channel] = stepToTime(releaseTimeTable, targetValue[3][channel]);
+
+  adsr_sustain[channel] = constrain(sustain, 0, adsr_sustain_max);
+  targetValue[2][channel] = (int16_t)((long)adsr_sustain[channel] * sustain_upper / adsr_sustain_max);
+
+  for (int param = 0; param < 4; param++)
+  {
+    lastEncoderValue[param][channel] = -1; // Resync the encoder to the new target
+  }
+}
+
+// One parameter of one channel, as setChannelParameters(): 0 attack, 1 decay, 3 release as steps, 2 sustain as the level
+void setChannelParameter(int channel, int parameter, int value)
+{
+  switch (parameter)
+  {
+  case 0:
+    targetValue[0][channel] = constrain(value, 0, time_upper);
+    adsr_attack[channel] = stepToTime(attackDecayTimeTable, targetValue[0][channel]);
+    break;
+  case 1:
+    targetValue[1][channel] = constrain(value, 0, time_upper);
+    adsr_decay[channel] = stepToTime(attackDecayTimeTable, targetValue[1][channel]);
+    break;
+  case 2:
+    adsr_sustain[channel] = constrain(value, 0, adsr_sustain_max);
+    targetValue[2][channel] = (int16_t)((long)adsr_sustain[channel] * sustain_upper / adsr_sustain_max);
+    break;
+  case 3:
+    targetValue[3][channel] = constrain(value, 0, time_upper);
+    adsr_release[channel] = stepToTime(releaseTimeTable, targetValue[3][channel]);
+    break;
+  default:
+    return;
+  }
+  lastEncoderValue[parameter][channel] = -1;
+}
+
+void printReadEncoderCost()
+{
+  uint32_t cyclesPerUs = rp2040.f_cpu() / 1000000;
+  Serial.print("readEncoder cycles: idle=");
+  Serial.print(readEncoderIdleCycles);
+  Serial.print(" (");
+  Serial.print(readEncoderIdleCycles / cyclesPerUs);
+  Serial.print("us) moving=");
+  Serial.print(readEncoderMovingCycles);
+  Serial.print(" (");
+  Serial.print(readEncoderMovingCycles / cyclesPerUs);
+  Serial.println("us)");
+}
@@ -0,0 +1,18 @@
+#include "factory_presets.h"
+#include "encoder_read.h"
+
+int factoryPresetSelected[NUM_CHANNELS];
+
+// Like an encoder turn, the envelope takes the new values on its next frame
+void applyFactoryPreset(int channel, int index)
+{
+    index = constrain(index, 0, FACTORY_PRESETS - 1); // Also what is stored, the menu indexes by it
+    const FactoryPreset &preset = factoryPresets[index];
+    setChannelParameters(channel, preset.attackStep, preset.decayStep, preset.sustain, preset.releaseStep);
+    adsr_class[channel].set_attack(adsr_attack[channel]);
+    adsr_class[channel].set_decay(adsr_decay[channel]);
+    adsr_class[channel].set_sustain(adsr_sustain[channel]);
+    adsr_class[channel].set_release(adsr_release[channel]);
+    factoryPresetSelected[channel] = index;
+    paramsVersion++;
+}
@@ -0,0 +1,157 @@
+#include "flash_safe.h"
+#include "config.h"
+#include "dac_fifo.h"
+#include "dac.h"
+
+volatile bool flashSafeParkRequest = false; // Set by core0 for the length of a step
+volatile bool flashSafeParked = false;      // Core1 is in flashSafeParkLoop()
+
+bool flashSafeWaiting = false;
+uint32_t flashSafeWaitStart = 0;
+uint32_t flashSafeParkStart = 0;
+uint32_t flashSafeLastParkUs = 0;
+uint32_t flashSafeMaxParkUs = 0;
+uint32_t flashSafeSteps = 0;
+uint32_t flashSafeWaits = 0;
+uint32_t flashSafeMaxWaitMs = 0;
+uint32_t flashSafeForced = 0;
+volatile uint32_t flashSectorsErased = 0;
+volatile uint32_t flashPagesProgrammed = 0;
+
+#ifndef NATIVE_HAL
+#include <hardware/flash.h>
+
+// The linker sends every call to flash_range_erase() and flash_range_program() here first
+extern "C"
+{
+    void __real_flash_range_erase(uint32_t flash_offs, size_t count);
+    void __real_flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+    void __wrap_flash_range_erase(uint32_t flash_offs, size_t count)
+    {
+        flashSectorsErased += (count + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+        __real_flash_range_erase(flash_offs, count);
+    }
+
+    void __wrap_flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count)
+    {
+        flashPagesProgrammed += (count + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+        __real_flash_range_program(flash_offs, data, count);
+    }
+}
+#endif
+
+bool flashSafeReady()
+{
+    // A frame period back, so the frame last sent is steady too when core1 renders ahead
+    uint32_t now = millis();
+    if (adsr_class.is_steady(time_us_64() - dacSamplePeriodUs))
+    {
+        if (flashSafeWaiting)
+        {
+            flashSafeWaiting = false;
+            flashSafeMaxWaitMs = max(flashSafeMaxWaitMs, now - flashSafeWaitStart);
+        }
+        return true;
+    }
+
+    if (!flashSafeWaiting)
+    {
+        flashSafeWaiting = true;
+        flashSafeWaitStart = now;
+        flashSafeWaits++;
+        return false;
+    }
+
+    // Outputs that never settle don't hold the write off for good. The wait isn't started again
+    // until they do, so the later steps of the same save don't wait all over again.
+    if (now - flashSafeWaitStart >= FLASH_SAFE_MAX_WAIT_MS)
+    {
+        flashSafeMaxWaitMs = max(flashSafeMaxWaitMs, now - flashSafeWaitStart);
+        flashSafeForced++;
+        return true;
+    }
+    return false;
+}
+
+uint32_t flashSafeWaitingMs()
+{
+    return flashSafeWaiting ? millis() - flashSafeWaitStart : 0;
+}
+
+void flashSafeBegin()
+{
+    flashSafeParkRequest = true;
+    uint32_t start = micros();
+    while (!flashSafeParked && micros() - start < FLASH_SAFE_PARK_TIMEOUT_US)
+    {
+    }
+    flashSafeParkStart = micros();
+}
+
+void flashSafeEnd()
+{
+    flashSafeParkRequest = false;
+
+    // Wait for core1 to leave, so the next step's flashSafeBegin() doesn't see this park
+    uint32_t start = micros();
+    while (flashSafeParked && micros() - start < FLASH_SAFE_PARK_TIMEOUT_US)
+    {
+    }
+
+    flashSafeLastParkUs = micros() - flashSafeParkStart;
+    if (flashSafeLastParkUs > flashSafeMaxParkUs)
+    {
+        flashSafeMaxParkUs = flashSafeLastParkUs;
+    }
+    flashSafeSteps++;
+}
+
+// Runs from RAM and only touches RAM, so it keeps going while XIP is stopped. LittleFS's
+// idleOtherCore() interrupt still reaches core1 here, and arrives between frames.
+static void __not_in_flash_func(flashSafeParkLoop)()
+{
+    flashSafeParked = true;
+    while (flashSafeParkRequest)
+    {
+        tight_loop_contents();
+    }
+    flashSafeParked = false;
+}
+
+void flashSafePoll()
+{
+    if (!flashSafeParkRequest)
+    {
+        return;
+    }
+    dacFifoHold(true); // No timer frame starts while parked, the timer restarts on the current time after
+    flashSafeParkLoop();
+    dacFifoHold(false);
+}
+
+void printFlashSafe()
+{
+    Serial.print("Flash steps: ");
+    Serial.print(flashSafeSteps);
+    Serial.print(" waited: ");
+    Serial.print(flashSafeWaits);
+    Serial.print(" max ms: ");
+    Serial.print(flashSafeMaxWaitMs);
+    Serial.print(" forced: ");
+    Serial.print(flashSafeForced);
+    if (flashSafeWaiting)
+    {
+        Serial.print(" waiting now ms: ");
+        Serial.print(flashSafeWaitingMs());
+    }
+    Serial.print(" sectors erased: ");
+    Serial.print(flashSectorsErased);
+    Serial.print(" pages programmed: ");
+    Serial.print(flashPagesProgrammed);
+    Serial.print(" core1 parked last: ");
+    Serial.print(flashSafeLastParkUs);
+    Serial.print(" us max: ");
+    Serial.print(flashSafeMaxParkUs);
+    Serial.println(" us");
+}
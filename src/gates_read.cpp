@@ -1,6 +1,7 @@
 #include "Arduino.h"
 #include "gates_read.h"
 #include "config.h"
+#include "dac_fifo.h"
 
 // Shared variables between cores - must be volatile
 volatile bool gateHigh[4] = {false, false, false, false};
@@ -8,7 +9,7 @@ volatile bool gateHighProcessed[4] = {false, false, false, false};
 //olatile boolean gateLow[4] = {true, true, true, true};
 volatile int lastGateState[4] = {HIGH, HIGH, HIGH, HIGH};
 
-bool trigger_on[4] = {false, false, false, false}; // simple bool to switch trigger on and off per channel
+bool trigger_on[NUM_CHANNELS]; // simple bool to switch trigger on and off per channel
 
 void setupGates()
 {
@@ -21,18 +22,27 @@ void setupGates()
 
 void gatesUpdate()
 {
-  for (int ch = 0; ch < 4; ch++)
+  // Read each gate once, then apply it to every channel that follows it
+  bool gateOpen[NUM_GATES];
+  for (int gate = 0; gate < NUM_GATES; gate++)
   {
-    if (trigger_on[ch] == false && !checkGates(ch + 1))
+    gateOpen[gate] = !checkGates(gate + 1);
+  }
+
+  for (int ch = 0; ch < NUM_CHANNELS; ch++)
+  {
+    if (trigger_on[ch] == false && gateOpen[ch % NUM_GATES])
     {
       trigger_on[ch] = true;
       adsr_class[ch].note_on();
+      dacFifoInvalidate(); // Re-render the frames already queued
       // Serial.println("Gate HIGH");
     }
-    else if (trigger_on[ch] == true && checkGates(ch + 1))
+    else if (trigger_on[ch] == true && !gateOpen[ch % NUM_GATES])
     {
       trigger_on[ch] = false;
       adsr_class[ch].note_off();
+      dacFifoInvalidate();
       // Serial.println("Gate LOW");
     }
   }
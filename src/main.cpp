@@ -2,13 +2,25 @@
 #include <SPI.h>
 #include <Arduino.h>
 #include <dac.h>
+#include "dac_fifo.h"
+#include "output_trace.h"
 #include "encoder.h"
 #include "encoder_read.h"
 #include "oled.h"
+#include "oled_profiler.h"
 #include <U8g2lib.h>
 #include <Wire.h>
 #include "buttons.h"
 #include "gates_read.h"
+#include "config.h"
+#include "presets.h"
+#include "flash_safe.h"
+#include "autosave.h"
+#include "boot.h"
+#include "factory_presets.h"
+#include "morph.h"
+#include "scenes.h"
+#include "bench.h"
 
 #define DACSIZE 4096 // vertical resolution of the DACs
 
@@ -16,51 +28,159 @@ const uint8_t LOWER_LIMIT = 0;
 const uint16_t UPPER_LIMIT = 1000;
 const uint8_t GAIN_MAX = 8;
 
-// Default variables
-unsigned long adsr_attack[4] = {100000, 100000, 100000, 100000};//100000;            // time in µs
-unsigned long adsr_decay[4] = {100000, 100000, 100000, 100000};             // time in µs
-int           adsr_sustain[4] = {2500, 2500, 2500, 2500};//2500;             // sustain level -> from 0 to DACSIZE-1
-unsigned long adsr_release[4] = {1000000, 1000000, 1000000, 1000000};         // time in µs
+unsigned long adsr_attack[NUM_CHANNELS];            // time in µs
+unsigned long adsr_decay[NUM_CHANNELS];             // time in µs
+int           adsr_sustain[NUM_CHANNELS];           // sustain level -> from 0 to DACSIZE-1
+unsigned long adsr_release[NUM_CHANNELS];           // time in µs
+uint32_t paramsVersion = 0;                         // bumped on every parameter change
 
 // internal classes
-ADSR adsr_class[4] = {ADSR(DACSIZE), ADSR(DACSIZE), ADSR(DACSIZE), ADSR(DACSIZE)}; // ADSR class initialisation, one per channel
+ADSRBank<NUM_CHANNELS, NUM_SCENES> adsr_class; // ADSR class initialisation, one per channel (DACSIZE resolution)
 
-int channel_selected = 1; // currently selected channel (1-4)
+int channel_selected = 1; // currently selected channel (1-NUM_CHANNELS)
+int channel_page = 0;     // page of 4 channels the buttons select from
+
+// Core1 profiling, smoothed CPU cycles per frame
+volatile uint32_t core1RenderCycles = 0; // envelope maths and calibration for all channels
+volatile uint32_t core1WriteCycles = 0;  // handing the frame to the DAC driver
+void printCore1Profile();
+
+// Core0 loop time, to check the display and serial output don't hold up inputs
+uint32_t core0LoopCount = 0;
+uint32_t core0LoopMaxUs = 0;
+uint32_t core0Loops = 0;      // Free running, for the profiler overlay
+uint32_t core0DrawCycles = 0;
+void printCore0Profile();
 
 State currentState = ADSR_SCREEN; // Default state
 
+bool profileSerialPrint = false; // Set to true to print readEncoder() cost, DAC frame rate and skew once a second
+bool fifoBenchmarkSerialPrint = false; // Set to true to print DAC FIFO latency against depth once after boot
+bool bootSerialPrint = false; // Set to true to print the startup phase times once after boot
+bool presetSaveTestSerialPrint = false; // Set to true to print output frame gaps during preset saves once after boot
+bool benchSerialPrint = false; // Set to true to print the hot path microbenchmarks as CSV once after boot
+bool traceSerialPrint = false; // Set to true to stream every traceSerialDecimation-th DAC frame to serial as CSV
+const uint32_t traceSerialDecimation = 100;
+
 void setup()
 {
-  encoderSetup();
+  bootMark(BOOT_SETUP);
+
+  // Core1 starts rendering as soon as its setup is done, so the envelopes get
+  // their defaults (factory shape 0) before anything else. The saved state follows in bootService().
   setupEncoderRead();
-  oledSetup();
+  for (int ch = 0; ch < NUM_CHANNELS; ch++)
+  {
+    applyFactoryPreset(ch, 0);
+  }
+  setupScenes();
 
   // analogWriteResolution(12);                        // set the analog output resolution to 12 bit (4096 levels) -> ARDUINO DUE ONLY
 
   pinMode(LED_BUILTIN, OUTPUT); // initialize LED
 
+  setupGates();
+
   setupButtons();
+  bootMark(BOOT_GATES_LIVE);
 
-  setupGates();
+  if (traceSerialPrint)
+  {
+    outputTraceDecimation = traceSerialDecimation;
+  }
+  // Filesystem, encoders, saved state and display are brought up by bootService() from loop()
 }
 
 void loop()
 { 
+  // Until startup is finished, just the gates and one startup step per pass
+  if (!bootComplete())
+  {
+    gatesUpdate();
+    bootService();
+    return;
+  }
+
+  static uint32_t lastLoopStart = 0;
+  uint32_t loopStart = micros();
+  if (core0LoopCount > 0 && loopStart - lastLoopStart > core0LoopMaxUs)
+  {
+    core0LoopMaxUs = loopStart - lastLoopStart;
+  }
+  lastLoopStart = loopStart;
+  core0LoopCount++;
+  core0Loops++;
+
   readEncoder(LOWER_LIMIT, UPPER_LIMIT, GAIN_MAX, 1, channel_selected); // Attack
   readEncoder(LOWER_LIMIT, UPPER_LIMIT, GAIN_MAX, 2, channel_selected); // Decay
   readEncoder(LOWER_LIMIT, UPPER_LIMIT, GAIN_MAX, 3, channel_selected); // Sustain
   readEncoder(LOWER_LIMIT, UPPER_LIMIT, GAIN_MAX, 4, channel_selected); // Release
 
   encoderUpdate(); 
+  morphService();
 
   static unsigned long lastSlowUpdate = 0;
   unsigned long currentTime = millis();
   if (currentTime - lastSlowUpdate >= 6)
   {
+    uint32_t drawStart = rp2040.getCycleCount();
     oledUpdate();
+    core0DrawCycles += rp2040.getCycleCount() - drawStart;
     lastSlowUpdate = currentTime;
   }
 
+  static unsigned long lastProfilePrint = 0;
+  if (profileSerialPrint && currentTime - lastProfilePrint >= 1000)
+  {
+    printReadEncoderCost();
+    printDacFrameRate();
+    printCore1Profile();
+    printDacSkew();
+    requestDacSkewMeasurement(); // Printed next time round
+    printDacFifo();
+    printOledStats();
+    printCore0Profile();
+    printPresets();
+    printFlashSafe();
+    printAutosave();
+    printMorph();
+    printScenes();
+    lastProfilePrint = currentTime;
+  }
+
+  if (fifoBenchmarkSerialPrint && currentTime > 2000)
+  {
+    runDacFifoBenchmark();
+    fifoBenchmarkSerialPrint = false;
+  }
+
+  if (bootSerialPrint && currentTime > 2000)
+  {
+    printBootProfile();
+    bootSerialPrint = false;
+  }
+
+  if (presetSaveTestSerialPrint && currentTime > 2000)
+  {
+    runPresetSaveTest();
+    presetSaveTestSerialPrint = false;
+  }
+
+  if (benchSerialPrint && currentTime > 2000)
+  {
+    runBenchmarks();
+    benchSerialPrint = false;
+  }
+
+  bootFilesystemService();
+  presetService();
+  autosaveService();
+
+  if (traceSerialPrint)
+  {
+    printOutputTrace();
+  }
+
   buttonsUpdate();
 
   gatesUpdate();
@@ -68,22 +188,81 @@ void loop()
 
 void setup1()
 {
-    SPI.begin();
   Serial.begin(115200);
-  delay(100);
 
   setupDAC();
+  setupDacFifo();
+  bootMark(BOOT_OUTPUT_READY);
 }
 
 void loop1()
 {
-  for (int ch = 0; ch < 4; ch++) {
-      int env_value = adsr_class[ch].envelope();
-      // Serial.print("ADSR Envelope Value: ");
-      // Serial.println(env_value);
+  flashSafePoll();      // Parked here while core0 writes flash
+  applyPendingPreset(); // All channels of a loaded preset change between two frames
+  applyPendingScene();  // Likewise a scene switch
 
-      cacheDacValue(ch, env_value); // Cache DAC value for channel ch
+#if DAC_FIFO_DEPTH > 0
+  // Render ahead into the FIFO, the DAC is written from a timer interrupt
+  uint32_t startCycles = rp2040.getCycleCount();
+  if (dacFifoService())
+  {
+    core1RenderCycles += ((int32_t)(rp2040.getCycleCount() - startCycles) - (int32_t)core1RenderCycles) / 16;
   }
+  core1WriteCycles = dacFifoWriteCycles;
+#else
+  // Pace the engine to the DAC driver's frame time
+  static uint32_t nextFrameTime = 0;
+  while ((int32_t)(time_us_32() - nextFrameTime) < 0)
+  {
+  }
+  nextFrameTime = time_us_32() + dacSamplePeriodUs;
+
+  uint32_t startCycles = rp2040.getCycleCount();
+
+  int env_values[NUM_CHANNELS];
+  adsr_class.render(env_values);
+  for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+      cacheDacValue(ch, env_values[ch]); // Cache DAC value for channel ch
+  }
+
+  uint32_t renderedCycles = rp2040.getCycleCount();
   
   dacWrite();                  // Write cached values to DAC
+
+  uint32_t writtenCycles = rp2040.getCycleCount();
+  core1RenderCycles += ((int32_t)(renderedCycles - startCycles) - (int32_t)core1RenderCycles) / 16;
+  core1WriteCycles += ((int32_t)(writtenCycles - renderedCycles) - (int32_t)core1WriteCycles) / 16;
+#endif
+}
+
+// Core1 cost per frame, and how many channels would fit at the current frame rate
+void printCore1Profile()
+{
+  uint32_t perChannel = core1RenderCycles / NUM_CHANNELS + core1WriteCycles / NUM_CHANNELS;
+  uint32_t frameRate = dacFramesPerSecond ? dacFramesPerSecond : 1;
+  uint32_t cyclesPerFrame = rp2040.f_cpu() / frameRate;
+  Serial.print("core1 cycles/frame: render=");
+  Serial.print(core1RenderCycles);
+  Serial.print(" write=");
+  Serial.print(core1WriteCycles);
+  Serial.print(" per channel=");
+  Serial.print(perChannel);
+  Serial.print(" max channels at ");
+  Serial.print(frameRate);
+  Serial.print(" frames/s=");
+  Serial.println(perChannel ? cyclesPerFrame / perChannel : 0);
+}
+
+// Average and longest core0 loop since the last print, then start again
+void printCore0Profile()
+{
+  static uint32_t lastPrint = 0;
+  uint32_t now = micros();
+  Serial.print("core0 loop us: avg=");
+  Serial.print(core0LoopCount ? (now - lastPrint) / core0LoopCount : 0);
+  Serial.print(" max=");
+  Serial.println(core0LoopMaxUs);
+  lastPrint = now;
+  core0LoopCount = 0;
+  core0LoopMaxUs = 0;
 }
@@ -0,0 +1,185 @@
+#include "morph.h"
+#include "presets.h"
+#include "encoder.h"
+#include "encoder_read.h"
+#include "oled.h"
+#include "text_format.h"
+#include <U8g2lib.h>
+
+int morphSlotA = 0;
+int morphSlotB = 1;
+int morphPosition = 0;
+uint32_t morphValuesPublished = 0;
+uint32_t morphLastUpdateCycles = 0;
+
+// End points and what was last published, [channel][parameter] in setChannelParameter() units
+int16_t morphFrom[NUM_CHANNELS][4];
+int16_t morphTo[NUM_CHANNELS][4];
+int16_t morphValue[NUM_CHANNELS][4];
+int morphLastDetent = 0;
+
+static void morphCopyRecord(const PresetRecord &record, int16_t values[NUM_CHANNELS][4])
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        values[ch][0] = record.channel[ch].attack;
+        values[ch][1] = record.channel[ch].decay;
+        values[ch][2] = record.channel[ch].sustain;
+        values[ch][3] = record.channel[ch].release;
+    }
+}
+
+// Recompute at the current position and publish the values that moved
+static void morphPublish()
+{
+    uint32_t start = rp2040.getCycleCount();
+    uint32_t published = 0;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        for (int param = 0; param < 4; param++)
+        {
+            int from = morphFrom[ch][param];
+            int delta = (morphTo[ch][param] - from) * morphPosition;
+            int value = from + (delta + (delta < 0 ? -MORPH_STEPS / 2 : MORPH_STEPS / 2)) / MORPH_STEPS;
+            if (value == morphValue[ch][param])
+            {
+                continue;
+            }
+            morphValue[ch][param] = value;
+            setChannelParameter(ch, param, value);
+            switch (param)
+            {
+            case 0:
+                adsr_class[ch].set_attack(adsr_attack[ch]);
+                break;
+            case 1:
+                adsr_class[ch].set_decay(adsr_decay[ch]);
+                break;
+            case 2:
+                adsr_class[ch].set_sustain(adsr_sustain[ch]);
+                break;
+            default:
+                adsr_class[ch].set_release(adsr_release[ch]);
+                break;
+            }
+            published++;
+        }
+    }
+    if (published > 0)
+    {
+        paramsVersion++;
+    }
+    morphValuesPublished = published;
+    morphLastUpdateCycles = rp2040.getCycleCount() - start;
+}
+
+bool morphEnter(int slotA, int slotB)
+{
+    PresetRecord a;
+    PresetRecord b;
+    if (!readPreset(slotA, a) || !readPreset(slotB, b))
+    {
+        return false;
+    }
+    morphSlotA = slotA;
+    morphSlotB = slotB;
+    morphCopyRecord(a, morphFrom);
+    morphCopyRecord(b, morphTo);
+
+    // Start from what the channels have now, so entering at A publishes only what differs from it
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        morphValue[ch][0] = getTargetValue(0, ch);
+        morphValue[ch][1] = getTargetValue(1, ch);
+        morphValue[ch][2] = adsr_sustain[ch];
+        morphValue[ch][3] = getTargetValue(3, ch);
+    }
+    morphPosition = 0;
+    morphPublish();
+
+    int position, step;
+    getEncoder1Position(&position, &step);
+    morphLastDetent = step / 4;
+
+    currentState = MORPH_SCREEN;
+    uiVersion++;
+    return true;
+}
+
+void morphService()
+{
+    if (currentState != MORPH_SCREEN)
+    {
+        return;
+    }
+    int position, step;
+    getEncoder1Position(&position, &step);
+    int detent = step / 4;
+    if (detent == morphLastDetent)
+    {
+        return;
+    }
+    int newPosition = constrain(morphPosition + detent - morphLastDetent, 0, MORPH_STEPS);
+    morphLastDetent = detent;
+    if (newPosition == morphPosition)
+    {
+        return; // Turning against an end
+    }
+    morphPosition = newPosition;
+    morphPublish();
+    uiVersion++;
+}
+
+// "Morph 3 > 4", a bar for the position and the selected channel's values
+void morphDraw()
+{
+    char line[32];
+    int n = formatText(line, sizeof(line), "Morph ");
+    n += formatInt(line + n, sizeof(line) - n, morphSlotA + 1);
+    n += formatText(line + n, sizeof(line) - n, " > ");
+    n += formatInt(line + n, sizeof(line) - n, morphSlotB + 1);
+    n += formatText(line + n, sizeof(line) - n, "  ");
+    n += formatPercent(line + n, sizeof(line) - n, morphPosition, MORPH_STEPS, 0);
+    formatText(line + n, sizeof(line) - n, "%");
+    u8g2.setFont(smallFont);
+    u8g2.setDrawColor(1);
+    u8g2.setCursor(3, 9);
+    u8g2.print(line);
+
+    u8g2.drawFrame(3, 16, 122, 10);
+    u8g2.drawBox(4, 17, (120 * morphPosition) / MORPH_STEPS, 8);
+
+    int ch = channel_selected - 1;
+    n = formatText(line, sizeof(line), "Ch");
+    n += formatInt(line + n, sizeof(line) - n, channel_selected);
+    n += formatText(line + n, sizeof(line) - n, " A ");
+    n += formatDuration(line + n, sizeof(line) - n, adsr_attack[ch]);
+    n += formatText(line + n, sizeof(line) - n, " D ");
+    formatDuration(line + n, sizeof(line) - n, adsr_decay[ch]);
+    u8g2.setCursor(3, 40);
+    u8g2.print(line);
+
+    n = formatText(line, sizeof(line), "S ");
+    n += formatPercent(line + n, sizeof(line) - n, adsr_sustain[ch], adsr_sustain_max, 0);
+    n += formatText(line + n, sizeof(line) - n, "% R ");
+    formatDuration(line + n, sizeof(line) - n, adsr_release[ch]);
+    u8g2.setCursor(3, 52);
+    u8g2.print(line);
+}
+
+void printMorph()
+{
+    Serial.print("morph: ");
+    Serial.print(morphSlotA + 1);
+    Serial.print(">");
+    Serial.print(morphSlotB + 1);
+    Serial.print(" at ");
+    Serial.print(morphPosition);
+    Serial.print("/");
+    Serial.print(MORPH_STEPS);
+    Serial.print(", last detent published ");
+    Serial.print(morphValuesPublished);
+    Serial.print(" values in ");
+    Serial.print(morphLastUpdateCycles);
+    Serial.println(" cycles");
+}
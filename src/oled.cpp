@@ -6,6 +6,16 @@
 #include <Wire.h>
 #include "adsr.h"
 #include "config.h"
+#include "buttons.h"
+#include "oled_async.h"
+#include "oled_scope.h"
+#include "oled_profiler.h"
+#include "text_format.h"
+#include "presets.h"
+#include "boot.h"
+#include "factory_presets.h"
+#include "morph.h"
+#include "scenes.h"
 
 // Using the I2C interface for a 128x64 SSD1306 OLED
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/U8X8_PIN_NONE);
@@ -16,10 +26,24 @@ const uint8_t *smallFont = u8g2_font_boutique_bitmap_9x9_tr; // 6px height font
 
 // Variables
 unsigned long previousMillis = 0;
-const unsigned long refreshInterval = 50; // Update interval in ms
+const unsigned long refreshInterval = OLED_REFRESH_INTERVAL_MS; // Update interval in ms
 int lastTargetValue = -1;                 // To track the last target value
 int lastPositionValue = -1;               // To track the last encoder position value
-bool oledUpdateNeeded = false;            // Flag to indicate if an update is needed
+uint32_t uiVersion = 0;                   // Bumped whenever the screen state changes (menu, channel, popups)
+uint32_t oledFramesSent = 0;              // Frames sent to the display, stays still while nothing changes
+
+// Partial updates: a copy of what the panel shows, so only changed 8x8 tiles are sent
+const int OLED_TILE_COLUMNS = 16;
+const int OLED_TILE_ROWS = 8;
+uint8_t oledSentBuffer[OLED_TILE_ROWS * OLED_TILE_COLUMNS * 8]; // What the panel shows, valid after the first frame
+bool oledFullFramePending = false; // The panel RAM is undefined after power-on, so the first frame sends every tile
+bool oledPowerOnPending = false;   // Panel switched on once the first frame is out
+uint32_t oledLastFrameBytes = 0;          // Display data bytes in the last frame
+uint32_t oledLastFrameUs = 0;             // I2C transfer time of the last frame
+uint32_t oledLastBlockedUs = 0;           // Time core0 spent in the last frame's send, queueing only with DMA
+uint32_t oledBytesSent = 0;               // Display data bytes since boot
+uint32_t oledLastComposeUs = 0;           // Time to draw the last frame into the buffer
+uint32_t oledFormatCycles = 0;            // Cycles spent formatting the parameter line of the last ADSR screen frame
 uint8_t lastDisplayedMode = 255;          // To track the last mode displayed on OLED (initialise to invalid value)
 bool popupActive = false;                 // Flag to indicate if a popup is currently being displayed
 
@@ -49,21 +73,84 @@ bool copyProbability = true;
 bool copyRoll = true;
 
 // Menu arrays
-const int numMenuItems = 8;
-char menuItemNames[8][20] = {"Save", "Load", "blank", "blank", "blank", "blank", "blank", "blank"};
+const int numMenuItems = 10;
+char menuItemNames[10][20] = {"Save", "Load", "blank", "Scope: all", "Scope: selected", "Profiler: off", "Slot: 1", "Shape: Init", "Morph: 1 > 2", "Edit: playing"};
+const int MENU_ITEM_SAVE = 0; // Both use the slot shown by MENU_ITEM_SLOT
+const int MENU_ITEM_LOAD = 1;
+const int MENU_ITEM_PAGE = 2; // Channel page, only shown with more than 4 channels
+const int MENU_ITEM_SCOPE_ALL = 3;
+const int MENU_ITEM_SCOPE_SELECTED = 4;
+const int MENU_ITEM_PROFILER = 5;
+const int MENU_ITEM_SLOT = 6;
+const int MENU_ITEM_SHAPE = 7; // Factory shape of the selected channel, each press applies the next one
+const int MENU_ITEM_MORPH = 8; // From the slot shown by MENU_ITEM_SLOT to the one after it
+const int MENU_ITEM_SCENE_EDIT = 9; // Edit the playing scene or the next one
+
+// Label for the channel page item, e.g. "Page: 5-8"
+void updatePageMenuItem()
+{
+    if (NUM_PAGES > 1)
+    {
+        char *label = menuItemNames[MENU_ITEM_PAGE];
+        int size = sizeof(menuItemNames[MENU_ITEM_PAGE]);
+        int n = formatText(label, size, "Page: ");
+        n += formatInt(label + n, size - n, channel_page * 4 + 1);
+        n += formatText(label + n, size - n, "-");
+        formatInt(label + n, size - n, channel_page * 4 + 4);
+    }
+}
 
-void oledSetup()
+// Label for the preset slot item, e.g. "Slot: 12"
+void updateSlotMenuItem()
+{
+    char *label = menuItemNames[MENU_ITEM_SLOT];
+    int size = sizeof(menuItemNames[MENU_ITEM_SLOT]);
+    int n = formatText(label, size, "Slot: ");
+    formatInt(label + n, size - n, presetSlot + 1);
+
+    label = menuItemNames[MENU_ITEM_MORPH];
+    size = sizeof(menuItemNames[MENU_ITEM_MORPH]);
+    n = formatText(label, size, "Morph: ");
+    n += formatInt(label + n, size - n, presetSlot + 1);
+    n += formatText(label + n, size - n, " > ");
+    formatInt(label + n, size - n, (presetSlot + 1) % PRESET_SLOTS + 1);
+}
+
+// "Save: pending" from the request until the save is written, which waits for steady outputs
+static void updateSaveMenuItem()
 {
-    delay(100); // Show test message for 2 seconds
+    const char *label = presetSaveBusy() ? "Save: pending" : "Save";
+    if (strcmp(menuItemNames[MENU_ITEM_SAVE], label) != 0)
+    {
+        strcpy(menuItemNames[MENU_ITEM_SAVE], label);
+        uiVersion++;
+    }
+}
+
+void updateShapeMenuItem()
+{
+    char *label = menuItemNames[MENU_ITEM_SHAPE];
+    int size = sizeof(menuItemNames[MENU_ITEM_SHAPE]);
+    int n = formatText(label, size, "Shape: ");
+    formatText(label + n, size - n, factoryPresets[factoryPresetSelected[channel_selected - 1]].name);
+}
 
-    u8g2.begin();
+void oledSetup()
+{
+    // Controller setup only, the panel stays off. Instead of a blocking clear the first
+    // frame goes out whole over DMA, and the panel is switched on once it has arrived.
+    u8g2.initDisplay();
     u8g2.setFont(smallFont); // Set default font at initialization
-    u8g2.clear();
+    u8g2.clearBuffer();
 
     u8g2.setFontMode(1); // Transparent
     u8g2.setDrawColor(1);
     u8g2.setFontDirection(0);
-    u8g2.sendBuffer();
+    oledAsyncBegin();
+    oledFullFramePending = true;
+    oledPowerOnPending = true;
+
+    updatePageMenuItem();
 }
 
 // Clear a specific area on the display
@@ -74,7 +161,11 @@ void clearArea(int x, int y, int width, int height, int flash)
     {
         u8g2.setDrawColor(1);                           // Set to white
         u8g2.drawBox(x, y - height + 1, width, height); // Draw white box over the area
+        while (oledAsyncBusy())
+        {
+        }
         u8g2.sendBuffer();
+        memcpy(oledSentBuffer, u8g2.getBufferPtr(), sizeof(oledSentBuffer)); // Keep the partial update copy in step
     }
 
     u8g2.setDrawColor(0);                           // Set to black (clear)
@@ -114,6 +205,17 @@ void drawAngleLine(int centerX, int centerY, int radius, float startAngle, float
     u8g2.drawLine(centerX, centerY, endX, endY);
 }
 
+// A time parameter as percent of its range, e.g. "12.34" or "100.0"
+static int formatTimePercent(char *buf, int size, uint32_t value, long long full)
+{
+    uint32_t hundredths = ((uint64_t)value * 10000 + full / 2) / full;
+    if (hundredths >= 9999)
+    {
+        return formatFixed(buf, size, (hundredths + 5) / 10, 1);
+    }
+    return formatFixed(buf, size, hundredths, 2);
+}
+
 void displayParametersState()
 {
     int ch = channel_selected - 1; // 0-based channel index
@@ -159,13 +261,24 @@ void displayParametersState()
 
     // Show active channel
         // Calculate width of the number + "ms"
+    // With scenes, the one being edited first, in brackets while another one plays
     char temp[16]; // Buffer for the string
-    snprintf(temp, sizeof(temp), "Ch: %d", channel_selected);
+    int n = 0;
+    if (NUM_SCENES > 1)
+    {
+        int editing = adsr_class.editing_scene();
+        bool background = editing != adsr_class.playing_scene();
+        char letter[2] = {sceneLetter(editing), '\0'};
+        n = formatText(temp, sizeof(temp), background ? "(" : "");
+        n += formatText(temp + n, sizeof(temp) - n, letter);
+        n += formatText(temp + n, sizeof(temp) - n, background ? ") " : " ");
+    }
+    n += formatText(temp + n, sizeof(temp) - n, "Ch: ");
+    formatInt(temp + n, sizeof(temp) - n, channel_selected);
     int width = u8g2.getStrWidth(temp);
     // Right-align: set cursor to screen width minus width (adjust Y as needed)
     u8g2.setCursor(128 - width, 6); // Assuming same Y position
-    u8g2.print("Ch: ");
-    u8g2.print(channel_selected);
+    u8g2.print(temp);
 
     // Draw the ADSR envelope lines
     // Attack: from min to max
@@ -180,100 +293,219 @@ void displayParametersState()
     // Draw the total_time
     u8g2.setCursor(0, 64 - 10);
 
-    int division_factor = 10; // Scales down the time to human perception of when each phase occurs
-    const char *spacer = " ";
-    char buf[16]; // Buffer for formatted strings
-    // u8g2.print("A: ");
-    float val_attack = (adsr_attack[ch] * 100.0f) / adsr_attack_max;
-    if (val_attack >= 99.99f) {
-        sprintf(buf, "%.1f", val_attack);
-    } else {
-        sprintf(buf, "%.2f", val_attack);
-    }
+    // Percent of each range: two decimals, one from 99.99 up so the width stays the same.
+    // Sustain is whole percent of full scale.
+    uint32_t formatStart = rp2040.getCycleCount();
+    char buf[32]; // Buffer for formatted strings
+    n = formatTimePercent(buf, sizeof(buf), adsr_attack[ch], adsr_attack_max);
+    n += formatText(buf + n, sizeof(buf) - n, ">");
+    n += formatTimePercent(buf + n, sizeof(buf) - n, adsr_decay[ch], adsr_decay_max);
+    n += formatText(buf + n, sizeof(buf) - n, ">");
+    n += formatPercent(buf + n, sizeof(buf) - n, adsr_sustain[ch], 4095, 0);
+    n += formatText(buf + n, sizeof(buf) - n, "%>");
+    formatTimePercent(buf + n, sizeof(buf) - n, adsr_release[ch], adsr_release_max);
+    oledFormatCycles = rp2040.getCycleCount() - formatStart;
     u8g2.print(buf);
-    // u8g2.print(spacer);
-    u8g2.print(">");
-    // u8g2.print("D: ");
-    float val_decay = (adsr_decay[ch] * 100.0f) / adsr_decay_max;
-    if (val_decay >= 99.99f) {
-        sprintf(buf, "%.1f", val_decay);
-    } else {
-        sprintf(buf, "%.2f", val_decay);
+}
+
+// What the last frame sent was drawn from. A new frame is composed only when one of these changes.
+struct OledView
+{
+    State state;
+    int channel;
+    uint32_t paramsVersion;
+    uint32_t uiVersion;
+};
+OledView lastView = {ADSR_SCREEN, -1, 0, 0};
+
+static bool viewChanged(const OledView &a, const OledView &b)
+{
+    return a.state != b.state || a.channel != b.channel ||
+           a.paramsVersion != b.paramsVersion || a.uiVersion != b.uiVersion;
+}
+
+// Compare the frame buffer with what was last sent, one 8x8 tile (8 bytes, one per column) at a time.
+// Each tile row with changes is sent as one area, from its first to its last changed tile.
+void sendChangedTiles()
+{
+    uint8_t *buffer = u8g2.getBufferPtr();
+    uint32_t start = micros();
+    uint32_t bytes = 0;
+
+    for (int row = 0; row < OLED_TILE_ROWS; row++)
+    {
+        int first = -1;
+        int last = -1;
+        for (int column = 0; column < OLED_TILE_COLUMNS; column++)
+        {
+            int offset = (row * OLED_TILE_COLUMNS + column) * 8;
+            if (oledFullFramePending || memcmp(buffer + offset, oledSentBuffer + offset, 8) != 0)
+            {
+                if (first < 0)
+                {
+                    first = column;
+                }
+                last = column;
+            }
+        }
+        if (first < 0)
+        {
+            continue;
+        }
+
+        int offset = (row * OLED_TILE_COLUMNS + first) * 8;
+        int length = (last - first + 1) * 8;
+        if (oledAsync)
+        {
+            oledAsyncAddArea(row, first * 8, buffer + offset, length);
+        }
+        else
+        {
+            u8g2.updateDisplayArea(first, row, last - first + 1, 1);
+        }
+        memcpy(oledSentBuffer + offset, buffer + offset, length);
+        bytes += length;
     }
-    u8g2.print(buf);
-    // u8g2.print(spacer);
-    u8g2.print(">");
-    // u8g2.print("S: ");
-    int sustain_percent = round((adsr_sustain[ch] * 100.0) / 4095.0);
-    u8g2.print(sustain_percent);
-    u8g2.print("%");
-    u8g2.print(">");
-    // u8g2.print("R: ");
-    float val_release = (adsr_release[ch] * 100.0f) / adsr_release_max;
-    if (val_release >= 99.99f) {
-        sprintf(buf, "%.1f", val_release);
-    } else {
-        sprintf(buf, "%.2f", val_release);
+
+    oledFullFramePending = false;
+
+    // With DMA the transfer time is noted by oledAsyncBusy() when it completes
+    if (oledAsync)
+    {
+        oledAsyncSend();
+    }
+    oledLastBlockedUs = micros() - start;
+    if (!oledAsync)
+    {
+        oledLastFrameUs = oledLastBlockedUs;
+    }
+    oledLastFrameBytes = bytes;
+    oledBytesSent += bytes;
+
+    if (oledSerialPrint)
+    {
+        Serial.print("OLED frame: ");
+        Serial.print(bytes);
+        Serial.print(" bytes, core0 blocked ");
+        Serial.print(oledLastBlockedUs);
+        Serial.println(" us");
     }
-    u8g2.print(buf);
-    // u8g2.print(spacer);
-    //u8g2.print("ms");
-    
-    oledUpdateNeeded = true; // Ensure we update
 }
 
 void oledUpdate()
 {
     unsigned long currentMillis = millis();
 
-    // Check if it's time to update the counter
-    if (currentMillis - previousMillis >= refreshInterval)
+    // At most one frame per refreshInterval
+    if (currentMillis - previousMillis < refreshInterval)
     {
-        previousMillis = currentMillis;
+        return;
+    }
 
-        // if currentState changes, clear the whole display
-        // if (currentState != lastDisplayedState)
-        {
-            clearArea(0, 64, 128, 65, 0);
+    // The last frame is still going out. Changes are picked up once it's done.
+    if (oledAsyncBusy())
+    {
+        return;
+    }
+    if (oledAsync)
+    {
+        oledLastFrameUs = oledAsyncLastTransferUs;
+    }
+    if (oledPowerOnPending && oledFramesSent > 0)
+    {
+        u8g2.setPowerSave(0); // The first frame is in the panel RAM, nothing left over is shown
+        oledPowerOnPending = false;
+        bootMark(BOOT_DISPLAY);
+    }
 
-            // lastDisplayedState = currentState; // Update the last displayed state
-            oledUpdateNeeded = true; // Set the flag to update the display
-        }
+    if (currentState == MENU_SCREEN)
+    {
+        updateMenuHighlight();
+        updateSaveMenuItem();
+    }
+    if (lastView.state == SCOPE_SCREEN && currentState != SCOPE_SCREEN)
+    {
+        scopeExit();
+    }
+    int scopeColumns = (currentState == SCOPE_SCREEN) ? scopeReadSamples() : 0;
 
-        // Only update normal display if no popup is active
-        // if (!popupActive)
-        {
-            if (currentState == ADSR_SCREEN)
-            {
-                // Update the parameters state
-                displayParametersState();
-            }
-            else //if (currentState == MENU_SCREEN)
-            {
-                // Update the Menu (values) state
-                displayMenuState();
-            }
-        }
+    if (profilerUpdate())
+    {
+        uiVersion++;
+    }
 
-        // Send all drawing commands to the display
-        if (oledUpdateNeeded)
-        {
-            //   if (!spiBusy)
-            {
-                //       spiBusy = true;
+    OledView view = {currentState, channel_selected, paramsVersion, uiVersion};
+    bool changed = viewChanged(view, lastView) || oledFullFramePending;
+    if (!changed && scopeColumns == 0)
+    {
+        return; // Nothing visible changed, no I2C traffic
+    }
+    lastView = view;
+    previousMillis = currentMillis;
 
-                // Draw every pixel to measure active area
-                // u8g2.clearBuffer();
-                // u8g2.drawBox(0, 0, 128, 64);
+    // The scope scrolls what is already in the buffer and draws just the new columns.
+    // The profiler overlay would scroll with it, so while it's on the scope is redrawn whole.
+    uint32_t composeStart = micros();
+    if (currentState == SCOPE_SCREEN && !changed && !profilerOverlay && scopeColumns < SCOPE_COLUMNS)
+    {
+        scopeScroll(scopeColumns);
+        oledLastComposeUs = micros() - composeStart;
+        sendChangedTiles();
+        oledFramesSent++;
+        return;
+    }
 
-                u8g2.sendBuffer();
-                //       spiBusy = false;
-                oledUpdateNeeded = false; // Reset the flag after updating
-            }
-            // If SPI busy, leave oledUpdateNeeded = true and try again next cycle
-        }
+    u8g2.clearBuffer();
+    if (currentState == ADSR_SCREEN)
+    {
+        // Update the parameters state
+        displayParametersState();
     }
+    else if (currentState == SCOPE_SCREEN)
+    {
+        scopeDraw();
+    }
+    else if (currentState == MORPH_SCREEN)
+    {
+        morphDraw();
+    }
+    else //if (currentState == MENU_SCREEN)
+    {
+        // Update the Menu (values) state
+        displayMenuState();
+    }
+    if (profilerOverlay)
+    {
+        profilerDraw();
+    }
+    oledLastComposeUs = micros() - composeStart;
+
+    // Send only the tiles that differ from the last frame
+    sendChangedTiles();
+    oledFramesSent++;
+}
+// Frames sent in the last call's interval, zero while nobody touches the panel
+void printOledStats()
+{
+    static uint32_t lastFramesSent = 0;
+    static uint32_t lastBytesSent = 0;
+    Serial.print("OLED frames sent: ");
+    Serial.print(oledFramesSent - lastFramesSent);
+    Serial.print(" bytes: ");
+    Serial.print(oledBytesSent - lastBytesSent);
+    Serial.print(" last frame: ");
+    Serial.print(oledLastFrameBytes);
+    Serial.print(" bytes in ");
+    Serial.print(oledLastFrameUs);
+    Serial.print(" us, core0 blocked ");
+    Serial.print(oledLastBlockedUs);
+    Serial.print(" us, text formatting ");
+    Serial.print(oledFormatCycles);
+    Serial.println(" cycles");
+    lastFramesSent = oledFramesSent;
+    lastBytesSent = oledBytesSent;
 }
+
 /*
 void handleEncoderSwitch()
 {
@@ -374,6 +606,7 @@ void enterMenu()
 
     // Moving from PARAMETERS to a selection menu
     currentState = MENU_SCREEN; // Update the state
+    updateShapeMenuItem();      // The selected channel may have changed since
 
     // Initialise highlightedValue to match the current selection
     //if (newState == MEMORY_MENU && currentSaveSlot != 0)
@@ -386,10 +619,70 @@ void enterMenu()
     }
 
     // Flag that we need to reset the encoder tracking on next oledUpdate
-    oledUpdateNeeded = true;
+    uiVersion++;
 }
    
-void displayMenuState()
+// Act on the highlighted menu item, called when a button is pressed and released in the menu
+void menuSelect()
+{
+    switch (highlightedValue)
+    {
+    case MENU_ITEM_PAGE:
+        if (NUM_PAGES > 1)
+        {
+            // Move to the next page, keeping the selected channel's position on the encoders
+            int position = (channel_selected - 1) % 4;
+            channel_page = (channel_page + 1) % NUM_PAGES;
+            selectChannel(channel_page * 4 + position + 1);
+            updatePageMenuItem();
+        }
+        break;
+    case MENU_ITEM_SCOPE_ALL:
+    case MENU_ITEM_SCOPE_SELECTED:
+        scopeEnter(highlightedValue == MENU_ITEM_SCOPE_ALL);
+        break;
+    case MENU_ITEM_SAVE:
+        // Stay in the menu, the item shows the save pending until it is written. A request is
+        // refused while the last save is still pending, which the item is already showing.
+        requestPresetSave(presetSlot);
+        updateSaveMenuItem();
+        break;
+    case MENU_ITEM_LOAD:
+        loadPreset(presetSlot);
+        currentState = ADSR_SCREEN;
+        break;
+    case MENU_ITEM_SLOT:
+        presetSlot = (presetSlot + 1) % PRESET_SLOTS;
+        updateSlotMenuItem();
+        break;
+    case MENU_ITEM_MORPH:
+        if (!morphEnter(presetSlot, (presetSlot + 1) % PRESET_SLOTS))
+        {
+            currentState = ADSR_SCREEN;
+        }
+        break;
+    case MENU_ITEM_SCENE_EDIT:
+        sceneToggleEditOther();
+        strcpy(menuItemNames[MENU_ITEM_SCENE_EDIT], sceneEditOther ? "Edit: other" : "Edit: playing");
+        break;
+    case MENU_ITEM_SHAPE:
+        applyFactoryPreset(channel_selected - 1, (factoryPresetSelected[channel_selected - 1] + 1) % FACTORY_PRESETS);
+        updateShapeMenuItem();
+        break;
+    case MENU_ITEM_PROFILER:
+        profilerToggle();
+        strcpy(menuItemNames[MENU_ITEM_PROFILER], profilerOverlay ? "Profiler: on" : "Profiler: off");
+        currentState = ADSR_SCREEN;
+        break;
+    default:
+        break;
+    }
+
+    uiVersion++;
+}
+
+// Follow the encoder in the menu, the display is redrawn only when the highlight moves
+void updateMenuHighlight()
 {
     // maxValue switch
    //switch (currentState)
@@ -417,10 +710,13 @@ void displayMenuState()
         // Store current encoder position
         lastPositionValue = (step / 4);
 
-        // Clear display and request update
-        clearArea(0, 64, 128, 64, 0);
-        oledUpdateNeeded = true;
+        uiVersion++;
     }
+}
+
+void displayMenuState()
+{
+    maxValue = numMenuItems; // Number of menu items
 
     // Improved display window calculation to ensure the highlighted value is always visible
     int displayStartIndex;
@@ -487,11 +783,6 @@ void displayMenuState()
             u8g2.print(menuItemNames[i]);
         }
     }
-    //if (currentState == VALUES_CVCHANNEL)
-    {
-        oledUpdateNeeded = true; // Ensure we update the display to display the CV changing
-    }
-
     // Display arrow indicating the highlighted value
     u8g2.setDrawColor(0); // Black
     u8g2.setCursor(116, ((highlightedValue - displayStartIndex) * 10) + 17);
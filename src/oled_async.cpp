@@ -0,0 +1,104 @@
+#include "oled_async.h"
+#include <hardware/i2c.h>
+#include <hardware/dma.h>
+
+// The panel is on Wire, which is i2c0. Wire is only used by the display, so the DMA path can take
+// the hardware directly between U8g2 calls.
+i2c_inst_t *oledI2c = i2c0;
+
+bool oledAsync = false;
+uint32_t oledAsyncLastTransferUs = 0;
+
+// One word per byte for the I2C data register: the byte, plus STOP on the last byte of each write.
+// Each area is a command write (page, column) then a data write, worst case a full frame.
+const int OLED_ASYNC_MAX_WORDS = 8 * (4 + 1 + 128);
+uint32_t oledAsyncWords[OLED_ASYNC_MAX_WORDS];
+int oledAsyncCount = 0;
+
+int oledDmaChannel = -1;
+bool oledTransferActive = false;
+uint32_t oledTransferStart = 0;
+
+static inline void addByte(uint8_t data, bool stop)
+{
+    oledAsyncWords[oledAsyncCount++] = data | (stop ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+}
+
+bool oledAsyncBegin()
+{
+#if OLED_ASYNC_I2C
+    oledDmaChannel = dma_claim_unused_channel(false);
+    if (oledDmaChannel < 0)
+    {
+        Serial.println("OLED: no free DMA channel, using blocking I2C");
+        return false;
+    }
+
+    i2c_hw_t *hw = i2c_get_hw(oledI2c);
+    dma_channel_config c = dma_channel_get_default_config(oledDmaChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(oledI2c, true));
+    dma_channel_configure(oledDmaChannel, &c, &hw->data_cmd, oledAsyncWords, 0, false);
+
+    oledAsync = true;
+#endif
+    return oledAsync;
+}
+
+// Page addressing, as U8g2 sets up the SSD1306: select the page and start column, then the data
+// runs along the page
+void oledAsyncAddArea(int row, int column, const uint8_t *data, int length)
+{
+    addByte(0x00, false); // Command stream
+    addByte(0xB0 | row, false);
+    addByte(0x00 | (column & 0x0F), false);
+    addByte(0x10 | (column >> 4), true);
+
+    addByte(0x40, false); // Data stream
+    for (int i = 0; i < length; i++)
+    {
+        addByte(data[i], i == length - 1);
+    }
+}
+
+// Hand the queued areas to DMA and return straight away
+void oledAsyncSend()
+{
+    if (oledAsyncCount == 0)
+    {
+        return;
+    }
+
+    // Wire sets the target address per transfer, so set it back to the panel
+    i2c_hw_t *hw = i2c_get_hw(oledI2c);
+    hw->enable = 0;
+    hw->tar = OLED_I2C_ADDRESS;
+    hw->enable = 1;
+
+    oledTransferStart = micros();
+    oledTransferActive = true;
+    dma_channel_transfer_from_buffer_now(oledDmaChannel, oledAsyncWords, oledAsyncCount);
+    oledAsyncCount = 0;
+}
+
+// Done once DMA has emptied the buffer, the I2C FIFO has drained and the last STOP is out
+bool oledAsyncBusy()
+{
+    if (!oledTransferActive)
+    {
+        return false;
+    }
+
+    i2c_hw_t *hw = i2c_get_hw(oledI2c);
+    if (dma_channel_is_busy(oledDmaChannel) || !(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+        (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS))
+    {
+        return true;
+    }
+
+    oledTransferActive = false;
+    oledAsyncLastTransferUs = micros() - oledTransferStart;
+    return false;
+}
@@ -0,0 +1,115 @@
+#include <U8g2lib.h>
+#include "oled_profiler.h"
+#include "oled.h"
+#include "dac.h"
+#include "text_format.h"
+
+const int PROFILER_X = 40; // Box from here to the right edge, four lines high
+
+bool profilerOverlay = false;
+
+// Figures for the last interval
+uint32_t profilerLoopRate = 0;     // core0 loop() passes per second
+uint32_t profilerDrawPercent = 0;  // Share of core0 spent in oledUpdate(), the rest is polling inputs
+uint32_t profilerCore1Percent = 0; // Share of core1 spent rendering and writing frames
+
+uint32_t profilerLastTime = 0;
+uint32_t profilerLastLoops = 0;
+uint32_t profilerLastDrawCycles = 0;
+
+void profilerToggle()
+{
+    profilerOverlay = !profilerOverlay;
+    profilerLastTime = 0; // Start a fresh interval
+}
+
+bool profilerUpdate()
+{
+    if (!profilerOverlay)
+    {
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (profilerLastTime != 0 && now - profilerLastTime < PROFILER_INTERVAL_MS)
+    {
+        return false;
+    }
+
+    uint32_t loops = core0Loops;
+    uint32_t drawCycles = core0DrawCycles;
+    if (profilerLastTime != 0)
+    {
+        uint32_t elapsedMs = now - profilerLastTime;
+        uint64_t elapsedCycles = (uint64_t)rp2040.f_cpu() / 1000 * elapsedMs;
+        profilerLoopRate = (uint64_t)(loops - profilerLastLoops) * 1000 / elapsedMs;
+        profilerDrawPercent = (uint64_t)(drawCycles - profilerLastDrawCycles) * 100 / elapsedCycles;
+    }
+
+    // Core1 figures are smoothed cycles per frame, times frames per second
+    uint64_t core1Cycles = (uint64_t)(core1RenderCycles + core1WriteCycles) * dacFramesPerSecond;
+    profilerCore1Percent = core1Cycles * 100 / rp2040.f_cpu();
+
+    profilerLastTime = now;
+    profilerLastLoops = loops;
+    profilerLastDrawCycles = drawCycles;
+    return true;
+}
+
+// "1234" or "45.6k"
+static int formatRate(char *buf, int size, uint32_t perSecond)
+{
+    int n;
+    if (perSecond < 10000)
+    {
+        n = formatUInt(buf, size, perSecond);
+    }
+    else
+    {
+        n = formatFixed(buf, size, perSecond / 100, 1);
+        n += formatText(buf + n, size - n, "k");
+    }
+    return n;
+}
+
+static void profilerLine(int line, const char *text)
+{
+    u8g2.setCursor(PROFILER_X + 2, 7 + line * 8);
+    u8g2.print(text);
+}
+
+void profilerDraw()
+{
+    char text[24];
+    int n;
+
+    u8g2.setFont(smallFont);
+    u8g2.setDrawColor(0);
+    u8g2.drawBox(PROFILER_X, 0, 128 - PROFILER_X, 34);
+    u8g2.setDrawColor(1);
+    u8g2.drawFrame(PROFILER_X, 0, 128 - PROFILER_X, 34);
+
+    // Composing the last frame, then its I2C transfer
+    n = formatText(text, sizeof(text), "frm ");
+    formatDuration(text + n, sizeof(text) - n, oledLastComposeUs);
+    profilerLine(0, text);
+
+    n = formatText(text, sizeof(text), "i2c ");
+    formatDuration(text + n, sizeof(text) - n, oledLastFrameUs);
+    profilerLine(1, text);
+
+    // Loops per second and drawing share on core0, frames per second and load on core1
+    n = formatText(text, sizeof(text), "c0 ");
+    n += formatRate(text + n, sizeof(text) - n, profilerLoopRate);
+    n += formatText(text + n, sizeof(text) - n, " ");
+    n += formatUInt(text + n, sizeof(text) - n, profilerDrawPercent);
+    formatText(text + n, sizeof(text) - n, "%");
+    profilerLine(2, text);
+
+    n = formatText(text, sizeof(text), "c1 ");
+    n += formatRate(text + n, sizeof(text) - n, dacFramesPerSecond);
+    n += formatText(text + n, sizeof(text) - n, " ");
+    n += formatUInt(text + n, sizeof(text) - n, profilerCore1Percent);
+    formatText(text + n, sizeof(text) - n, "%");
+    profilerLine(3, text);
+}
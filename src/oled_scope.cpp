@@ -0,0 +1,164 @@
+#include <U8g2lib.h>
+#include "oled_scope.h"
+#include "oled.h"
+#include "output_trace.h"
+#include "dac.h"
+#include "text_format.h"
+#include "config.h"
+
+// Plot area: pages 1 to 7 of the display, page 0 is the title
+const int SCOPE_FIRST_PAGE = 1;
+const int SCOPE_TOP = SCOPE_FIRST_PAGE * 8;
+const int SCOPE_HEIGHT = 64 - SCOPE_TOP;
+
+bool scopeAllChannels = true;
+
+// History as plot y positions per channel, a ring of SCOPE_COLUMNS
+uint8_t scopeY[NUM_CHANNELS][SCOPE_COLUMNS];
+int scopeHead = 0;  // Next column to write
+int scopeCount = 0; // Columns stored
+
+OutputTraceReader scopeReader;
+uint32_t scopeNextColumnTime = 0;
+bool scopeOwnsTrace = false; // The scope turned the trace on, and turns it off again
+
+static inline uint8_t scopeValueToY(uint16_t value)
+{
+    return 63 - (value * (SCOPE_HEIGHT - 1)) / 4095;
+}
+
+static inline bool scopeShowsChannel(int ch)
+{
+    if (!scopeAllChannels)
+    {
+        return ch == channel_selected - 1;
+    }
+    return ch / 4 == channel_page;
+}
+
+// y of the column `age` columns back from the newest
+static inline uint8_t scopeColumnY(int ch, int age)
+{
+    return scopeY[ch][(scopeHead - 1 - age + SCOPE_COLUMNS) % SCOPE_COLUMNS];
+}
+
+void scopeEnter(bool allChannels)
+{
+    scopeAllChannels = allChannels;
+    scopeHead = 0;
+    scopeCount = 0;
+    scopeReader.next = outputTraceHead; // Only frames from now on
+    scopeNextColumnTime = 0;
+
+    if (outputTraceDecimation == 0)
+    {
+        uint32_t fps = dacFramesPerSecond ? dacFramesPerSecond : SCOPE_TRACE_RATE;
+        outputTraceDecimation = max(1UL, (unsigned long)(fps / SCOPE_TRACE_RATE));
+        scopeOwnsTrace = true;
+    }
+    currentState = SCOPE_SCREEN;
+    uiVersion++;
+}
+
+void scopeExit()
+{
+    if (scopeOwnsTrace)
+    {
+        outputTraceDecimation = 0;
+        scopeOwnsTrace = false;
+    }
+}
+
+int scopeReadSamples()
+{
+    OutputTraceFrame frames[16];
+    int columns = 0;
+    int count;
+    while ((count = readOutputTrace(scopeReader, frames, 16)) > 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            // Start, or restart after a long gap, at the first frame
+            if (scopeNextColumnTime == 0 || (int32_t)(frames[i].time_us - scopeNextColumnTime) > 4 * SCOPE_COLUMN_US)
+            {
+                scopeNextColumnTime = frames[i].time_us;
+            }
+            if ((int32_t)(frames[i].time_us - scopeNextColumnTime) < 0)
+            {
+                continue;
+            }
+
+            for (int ch = 0; ch < NUM_CHANNELS; ch++)
+            {
+                scopeY[ch][scopeHead] = scopeValueToY(frames[i].values[ch]);
+            }
+            scopeHead = (scopeHead + 1) % SCOPE_COLUMNS;
+            scopeCount = min(scopeCount + 1, SCOPE_COLUMNS);
+            scopeNextColumnTime += SCOPE_COLUMN_US;
+            columns++;
+        }
+    }
+    return min(columns, SCOPE_COLUMNS);
+}
+
+// Segments for the newest `columns` columns, ending at the right edge
+static void scopeDrawColumns(int columns)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        if (!scopeShowsChannel(ch))
+        {
+            continue;
+        }
+        for (int age = columns - 1; age >= 0; age--)
+        {
+            int x = SCOPE_COLUMNS - 1 - age;
+            if (age + 1 < scopeCount)
+            {
+                u8g2.drawLine(x - 1, scopeColumnY(ch, age + 1), x, scopeColumnY(ch, age));
+            }
+            else
+            {
+                u8g2.drawPixel(x, scopeColumnY(ch, age));
+            }
+        }
+    }
+}
+
+void scopeDraw()
+{
+    char title[24];
+    int n;
+    if (scopeAllChannels)
+    {
+        n = formatText(title, sizeof(title), "Scope: ");
+        n += formatInt(title + n, sizeof(title) - n, channel_page * 4 + 1);
+        n += formatText(title + n, sizeof(title) - n, "-");
+        formatInt(title + n, sizeof(title) - n, channel_page * 4 + 4);
+    }
+    else
+    {
+        n = formatText(title, sizeof(title), "Scope: Ch ");
+        formatInt(title + n, sizeof(title) - n, channel_selected);
+    }
+    u8g2.setFont(smallFont);
+    u8g2.setDrawColor(1);
+    u8g2.setCursor(3, 7);
+    u8g2.print(title);
+
+    scopeDrawColumns(scopeCount);
+}
+
+// The frame buffer is 128 bytes per page, one byte per column, so scrolling is a move along each page
+void scopeScroll(int columns)
+{
+    uint8_t *buffer = u8g2.getBufferPtr();
+    for (int page = SCOPE_FIRST_PAGE; page < 8; page++)
+    {
+        uint8_t *row = buffer + page * SCOPE_COLUMNS;
+        memmove(row, row + columns, SCOPE_COLUMNS - columns);
+        memset(row + SCOPE_COLUMNS - columns, 0, columns);
+    }
+    u8g2.setDrawColor(1);
+    scopeDrawColumns(columns);
+}
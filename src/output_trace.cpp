@@ -0,0 +1,65 @@
+#include "output_trace.h"
+
+OutputTraceFrame outputTrace[OUTPUT_TRACE_FRAMES];
+volatile uint32_t outputTraceHead = 0;
+volatile uint32_t outputTraceDecimation = 0;
+uint32_t outputTraceSkipped = 0;
+
+// Copy out up to max frames the reader hasn't seen, oldest first
+int readOutputTrace(OutputTraceReader &reader, OutputTraceFrame *out, int max)
+{
+    uint32_t head = outputTraceHead;
+    __dmb();
+
+    if (head - reader.next > OUTPUT_TRACE_FRAMES)
+    {
+        reader.dropped += head - reader.next - OUTPUT_TRACE_FRAMES;
+        reader.next = head - OUTPUT_TRACE_FRAMES;
+    }
+
+    uint32_t first = reader.next;
+    int count = 0;
+    while (reader.next != head && count < max)
+    {
+        out[count++] = outputTrace[reader.next & (OUTPUT_TRACE_FRAMES - 1)];
+        reader.next++;
+    }
+
+    // Core1 may have lapped us while copying. Only frames newer than the slot it is writing now are whole.
+    __dmb();
+    int32_t stale = (int32_t)(outputTraceHead - OUTPUT_TRACE_FRAMES + 1 - first);
+    if (stale > 0)
+    {
+        stale = min(stale, (int32_t)count);
+        memmove(out, out + stale, (count - stale) * sizeof(OutputTraceFrame));
+        count -= stale;
+        reader.dropped += stale;
+    }
+    return count;
+}
+
+// Stream new frames as CSV: time, then one column per channel
+void printOutputTrace()
+{
+    static OutputTraceReader reader;
+    static uint32_t lastDropped = 0;
+    OutputTraceFrame frames[16];
+
+    int count = readOutputTrace(reader, frames, 16);
+    for (int i = 0; i < count; i++)
+    {
+        Serial.print(frames[i].time_us);
+        for (int ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            Serial.print(",");
+            Serial.print(frames[i].values[ch]);
+        }
+        Serial.println();
+    }
+    if (reader.dropped != lastDropped)
+    {
+        Serial.print("# trace dropped ");
+        Serial.println(reader.dropped - lastDropped);
+        lastDropped = reader.dropped;
+    }
+}
@@ -0,0 +1,386 @@
+#include "presets.h"
+#include "encoder_read.h"
+#include "dac_fifo.h"
+#include "crc32.h"
+#include "text_format.h"
+#include "flash_safe.h"
+#include "dac.h"
+#include "log_time.h"
+#include <LittleFS.h>
+
+const uint16_t PRESET_MAGIC = 0x5350; // "PS"
+const uint8_t PRESET_VERSION = 1;
+const uint8_t PRESET_FLAG_RESET_ATTACK = 0x01;
+const char *presetDir = "/presets";
+const uint16_t presetStepMax = LOG_TIME_STEPS;
+
+int presetSlot = 0;
+volatile bool presetApplyPending = false;
+uint32_t presetLastLoadUs = 0;
+uint32_t presetLastSaveUs = 0;
+volatile uint32_t presetApplyCycles = 0;
+
+// Options for core1 to apply with the loaded times and levels
+bool presetResetAttack[NUM_CHANNELS];
+
+// "/presets/07.bin", or ".tmp" for the file a save writes first
+static void presetPath(char *path, int size, int slot, const char *extension)
+{
+    int n = formatText(path, size, presetDir);
+    n += formatText(path + n, size - n, slot < 9 ? "/0" : "/");
+    n += formatInt(path + n, size - n, slot + 1);
+    formatText(path + n, size - n, extension);
+}
+
+bool presetCleanupPending = false; // A .tmp left behind, removed by presetService()
+
+// First .tmp file in the preset directory. A .tmp left behind is a save that never got as far as
+// the rename, the slot itself is intact.
+static bool findPresetTemp(char *path, int size)
+{
+    Dir dir = LittleFS.openDir(presetDir);
+    while (dir.next())
+    {
+        String name = dir.fileName();
+        if (name.endsWith(".tmp"))
+        {
+            int n = formatText(path, size, presetDir);
+            n += formatText(path + n, size - n, "/");
+            formatText(path + n, size - n, name.c_str());
+            return true;
+        }
+    }
+    return false;
+}
+
+// At boot, with core1 already sending frames: only looks. Removing what a power cut left is a
+// flash step for presetService().
+void setupPresets()
+{
+    char path[32];
+    presetCleanupPending = findPresetTemp(path, sizeof(path));
+}
+
+// The record for the current settings
+void capturePreset(PresetRecord &record)
+{
+    memset(&record, 0, sizeof(record));
+    record.magic = PRESET_MAGIC;
+    record.version = PRESET_VERSION;
+    record.channels = NUM_CHANNELS;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        record.channel[ch].attack = getTargetValue(0, ch);
+        record.channel[ch].decay = getTargetValue(1, ch);
+        record.channel[ch].sustain = adsr_sustain[ch];
+        record.channel[ch].release = getTargetValue(3, ch);
+        record.channel[ch].flags = adsr_class[ch].get_reset_attack() ? PRESET_FLAG_RESET_ATTACK : 0;
+    }
+    record.crc = crc32(&record, offsetof(PresetRecord, crc));
+}
+
+// Inside a flash step. The directory is made by the first save, boot only reads.
+static bool writePresetFile(const char *path, const PresetRecord &record)
+{
+    if (!LittleFS.exists(presetDir))
+    {
+        LittleFS.mkdir(presetDir);
+    }
+    File file = LittleFS.open(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+    file.close();
+    return ok;
+}
+
+// Saves run as two flash steps, the write of the .tmp file and the rename over the slot, each
+// done by presetService() when flash_safe allows
+enum PresetSaveStep
+{
+    PRESET_SAVE_IDLE,
+    PRESET_SAVE_WRITE,
+    PRESET_SAVE_RENAME,
+};
+PresetSaveStep presetSaveStep = PRESET_SAVE_IDLE;
+PresetRecord presetSaveRecord; // Taken when the save was asked for
+char presetSaveTempPath[32];
+char presetSavePath[32];
+uint32_t presetSaveStart = 0;
+
+static void startPresetSave(const char *tempPath, const char *path)
+{
+    capturePreset(presetSaveRecord);
+    formatText(presetSaveTempPath, sizeof(presetSaveTempPath), tempPath);
+    formatText(presetSavePath, sizeof(presetSavePath), path);
+    presetSaveStart = micros();
+    presetSaveStep = PRESET_SAVE_WRITE;
+}
+
+bool requestPresetSave(int slot)
+{
+    if (slot < 0 || slot >= PRESET_SLOTS || presetSaveStep != PRESET_SAVE_IDLE)
+    {
+        return false;
+    }
+    char tempPath[32];
+    char slotPath[32];
+    presetPath(tempPath, sizeof(tempPath), slot, ".tmp");
+    presetPath(slotPath, sizeof(slotPath), slot, ".bin");
+    startPresetSave(tempPath, slotPath);
+    return true;
+}
+
+bool presetSaveBusy()
+{
+    return presetSaveStep != PRESET_SAVE_IDLE;
+}
+
+// One .tmp file per step, before any save
+static void presetCleanupStep()
+{
+    char path[32];
+    if (!findPresetTemp(path, sizeof(path)))
+    {
+        presetCleanupPending = false;
+        return;
+    }
+    flashSafeBegin();
+    bool removed = LittleFS.remove(path);
+    flashSafeEnd();
+    if (!removed)
+    {
+        presetCleanupPending = false; // Not retried every step, the next boot tries again
+    }
+}
+
+void presetService()
+{
+    if ((presetSaveStep == PRESET_SAVE_IDLE && !presetCleanupPending) || !flashSafeReady())
+    {
+        return;
+    }
+    if (presetCleanupPending)
+    {
+        presetCleanupStep();
+        return;
+    }
+
+    bool ok;
+    flashSafeBegin();
+    if (presetSaveStep == PRESET_SAVE_WRITE)
+    {
+        ok = writePresetFile(presetSaveTempPath, presetSaveRecord);
+        presetSaveStep = PRESET_SAVE_RENAME;
+    }
+    else
+    {
+        // The rename replaces the old record in one step
+        ok = LittleFS.rename(presetSaveTempPath, presetSavePath);
+        presetSaveStep = PRESET_SAVE_IDLE;
+    }
+    if (!ok)
+    {
+        LittleFS.remove(presetSaveTempPath);
+    }
+    flashSafeEnd();
+
+    if (!ok)
+    {
+        presetSaveStep = PRESET_SAVE_IDLE;
+        Serial.println("Preset save failed");
+    }
+    else if (presetSaveStep == PRESET_SAVE_IDLE)
+    {
+        presetLastSaveUs = micros() - presetSaveStart;
+        Serial.print("Preset saved: ");
+        Serial.println(presetSavePath);
+    }
+}
+
+// Saves the current settings several times, first straight through LittleFS as a plain save would,
+// then through presetService(), and prints the longest output frame gaps for each. A file of its
+// own is used, so no slot is touched.
+void runPresetSaveTest()
+{
+    const int rounds = 4;
+    char tempPath[32];
+    char path[32];
+    int n = formatText(tempPath, sizeof(tempPath), presetDir);
+    formatText(tempPath + n, sizeof(tempPath) - n, "/test.tmp");
+    n = formatText(path, sizeof(path), presetDir);
+    formatText(path + n, sizeof(path) - n, "/test.bin");
+
+    // Unguarded: LittleFS idles core1 wherever it is, for as long as each flash operation takes
+    dacFrameGapMaxUs = 0;
+    dacFrameGapMovedMaxUs = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        capturePreset(presetSaveRecord);
+        writePresetFile(tempPath, presetSaveRecord);
+        LittleFS.rename(tempPath, path);
+    }
+    delay(10); // Let a frame go out after the last stall, the gap is measured when it does
+    uint32_t plainGap = dacFrameGapMaxUs;
+    uint32_t plainMovedGap = dacFrameGapMovedMaxUs;
+
+    // Guarded: one step per call, in a steady window, with core1 parked between frames
+    uint32_t waits = flashSafeWaits;
+    uint32_t forced = flashSafeForced;
+    flashSafeMaxParkUs = 0;
+    dacFrameGapMaxUs = 0;
+    dacFrameGapMovedMaxUs = 0;
+    for (int i = 0; i < rounds; i++)
+    {
+        startPresetSave(tempPath, path);
+        while (presetSaveBusy())
+        {
+            presetService();
+        }
+    }
+    delay(10);
+    uint32_t guardedGap = dacFrameGapMaxUs;
+    uint32_t guardedMovedGap = dacFrameGapMovedMaxUs;
+
+    flashSafeBegin();
+    LittleFS.remove(path);
+    flashSafeEnd();
+
+    Serial.print("Preset save test, frame period ");
+    Serial.print(dacSamplePeriodUs);
+    Serial.print(" us, max frame gap / max gap with the output moving: plain ");
+    Serial.print(plainGap);
+    Serial.print(" / ");
+    Serial.print(plainMovedGap);
+    Serial.print(" us, flash safe ");
+    Serial.print(guardedGap);
+    Serial.print(" / ");
+    Serial.print(guardedMovedGap);
+    Serial.print(" us, longest park ");
+    Serial.print(flashSafeMaxParkUs);
+    Serial.print(" us, steps that waited ");
+    Serial.print(flashSafeWaits - waits);
+    Serial.print(", forced ");
+    Serial.println(flashSafeForced - forced);
+}
+
+bool presetRecordValid(const PresetRecord &record)
+{
+    if (record.magic != PRESET_MAGIC || record.version != PRESET_VERSION || record.channels != NUM_CHANNELS ||
+        record.crc != crc32(&record, offsetof(PresetRecord, crc)))
+    {
+        return false;
+    }
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        const PresetChannel &c = record.channel[ch];
+        if (c.attack > presetStepMax || c.decay > presetStepMax || c.release > presetStepMax || c.sustain > adsr_sustain_max)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Open, read and check one slot, with a message when there is nothing usable in it. One
+// fixed-size read and a check, so the time doesn't depend on what is stored.
+bool readPreset(int slot, PresetRecord &record)
+{
+    if (slot < 0 || slot >= PRESET_SLOTS)
+    {
+        return false;
+    }
+    char slotPath[32];
+    presetPath(slotPath, sizeof(slotPath), slot, ".bin");
+    File file = LittleFS.open(slotPath, "r");
+    if (!file)
+    {
+        Serial.print("Preset slot empty: ");
+        Serial.println(slot + 1);
+        return false;
+    }
+
+    bool valid = file.size() == sizeof(record) &&
+                 file.read((uint8_t *)&record, sizeof(record)) == sizeof(record) &&
+                 presetRecordValid(record);
+    file.close();
+    if (!valid)
+    {
+        Serial.print("Preset slot invalid: ");
+        Serial.println(slot + 1);
+        return false;
+    }
+    return true;
+}
+
+bool loadPreset(int slot)
+{
+    if (presetApplyPending)
+    {
+        return false;
+    }
+    uint32_t start = micros();
+
+    PresetRecord record;
+    if (!readPreset(slot, record))
+    {
+        return false;
+    }
+
+    applyPresetRecord(record);
+
+    presetLastLoadUs = micros() - start;
+    Serial.print("Preset loaded from slot ");
+    Serial.println(slot + 1);
+    return true;
+}
+
+void applyPresetRecord(const PresetRecord &record)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        const PresetChannel &c = record.channel[ch];
+        setChannelParameters(ch, c.attack, c.decay, c.sustain, c.release);
+        presetResetAttack[ch] = c.flags & PRESET_FLAG_RESET_ATTACK;
+    }
+    presetApplyPending = true;
+    paramsVersion++;
+}
+
+// Runs on core1 at the top of loop1(), before the next frame is rendered
+bool applyPendingPreset()
+{
+    if (!presetApplyPending)
+    {
+        return false;
+    }
+
+    uint32_t startCycles = rp2040.getCycleCount();
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        adsr_class[ch].set_attack(adsr_attack[ch]);
+        adsr_class[ch].set_decay(adsr_decay[ch]);
+        adsr_class[ch].set_sustain(adsr_sustain[ch]);
+        adsr_class[ch].set_release(adsr_release[ch]);
+        adsr_class[ch].set_reset_attack(presetResetAttack[ch]);
+    }
+    dacFifoInvalidate(); // Frames already queued were rendered with the old settings
+    presetApplyCycles = rp2040.getCycleCount() - startCycles;
+    presetApplyPending = false;
+    return true;
+}
+
+void printPresets()
+{
+    Serial.print("Preset slot ");
+    Serial.print(presetSlot + 1);
+    Serial.print(" last load: ");
+    Serial.print(presetLastLoadUs);
+    Serial.print(" us, core1 apply: ");
+    Serial.print(presetApplyCycles);
+    Serial.print(" cycles, last save: ");
+    Serial.print(presetLastSaveUs);
+    Serial.println(" us");
+}
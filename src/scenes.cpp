@@ -0,0 +1,100 @@
+#include "scenes.h"
+#include "encoder_read.h"
+#include "dac_fifo.h"
+#include "log_time.h"
+
+bool sceneEditOther = false;
+volatile int scenePlayRequest = -1;
+volatile uint32_t sceneSwitchCycles = 0;
+uint32_t sceneSwitches = 0;
+
+void setupScenes()
+{
+    for (int scene = 1; scene < NUM_SCENES; scene++)
+    {
+        adsr_class.copy_scene(0, scene);
+    }
+}
+
+// Scene playing, or about to
+static int scenePlaying()
+{
+    int request = scenePlayRequest;
+    return request >= 0 ? request : adsr_class.playing_scene();
+}
+
+// Point the setters at a scene and load its settings into the globals and encoder targets.
+// The bank already has them, so nothing is written to the envelopes.
+static void sceneEdit(int scene)
+{
+    if (scene == adsr_class.editing_scene())
+    {
+        return;
+    }
+    adsr_class.edit_scene(scene);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        const ADSR::Params &p = adsr_class.scene_params(scene, ch);
+        setChannelParameters(ch, logTimeToStep(attackDecayTimeTable, p.attack), logTimeToStep(attackDecayTimeTable, p.decay),
+                             p.sustain, logTimeToStep(releaseTimeTable, p.release));
+    }
+    paramsVersion++;
+}
+
+static int sceneToEdit(int playing)
+{
+    return sceneEditOther ? (playing + 1) % NUM_SCENES : playing;
+}
+
+void sceneSwitch()
+{
+    int next = (scenePlaying() + 1) % NUM_SCENES;
+    scenePlayRequest = next;
+    sceneEdit(sceneToEdit(next));
+    sceneSwitches++;
+    uiVersion++;
+
+    Serial.print("Scene ");
+    Serial.print(sceneLetter(next));
+    Serial.println(" playing");
+}
+
+void sceneToggleEditOther()
+{
+    sceneEditOther = !sceneEditOther;
+    sceneEdit(sceneToEdit(scenePlaying()));
+    uiVersion++;
+}
+
+char sceneLetter(int scene)
+{
+    return 'A' + scene;
+}
+
+bool applyPendingScene()
+{
+    int scene = scenePlayRequest;
+    if (scene < 0)
+    {
+        return false;
+    }
+    uint32_t startCycles = rp2040.getCycleCount();
+    adsr_class.play_scene(scene);
+    dacFifoInvalidate(); // Frames already queued were rendered from the old scene
+    sceneSwitchCycles = rp2040.getCycleCount() - startCycles;
+    scenePlayRequest = -1;
+    return true;
+}
+
+void printScenes()
+{
+    Serial.print("scenes: playing ");
+    Serial.print(sceneLetter(adsr_class.playing_scene()));
+    Serial.print(", editing ");
+    Serial.print(sceneLetter(adsr_class.editing_scene()));
+    Serial.print(", switches ");
+    Serial.print(sceneSwitches);
+    Serial.print(", last switch ");
+    Serial.print(sceneSwitchCycles);
+    Serial.println(" core1 cycles");
+}
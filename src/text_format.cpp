@@ -0,0 +1,120 @@
+#include "text_format.h"
+
+static const uint32_t powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+int formatText(char *buf, int size, const char *text)
+{
+    if (size <= 0)
+    {
+        return 0;
+    }
+    int n = 0;
+    while (text[n] && n < size - 1)
+    {
+        buf[n] = text[n];
+        n++;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+// Digits are produced backwards into a scratch buffer, then copied
+int formatUInt(char *buf, int size, uint32_t value)
+{
+    char digits[11];
+    int count = 0;
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    if (size <= 0)
+    {
+        return 0;
+    }
+    int n = 0;
+    while (count > 0 && n < size - 1)
+    {
+        buf[n++] = digits[--count];
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+int formatInt(char *buf, int size, int32_t value)
+{
+    if (value >= 0)
+    {
+        return formatUInt(buf, size, value);
+    }
+    int n = formatText(buf, size, "-");
+    return n + formatUInt(buf + n, size - n, -(uint32_t)value);
+}
+
+int formatFixed(char *buf, int size, int32_t value, int decimals)
+{
+    decimals = constrain(decimals, 0, 9);
+    int n = 0;
+    uint32_t magnitude = value;
+    if (value < 0)
+    {
+        n = formatText(buf, size, "-");
+        magnitude = -(uint32_t)value;
+    }
+
+    uint32_t scale = powersOfTen[decimals];
+    n += formatUInt(buf + n, size - n, magnitude / scale);
+    if (decimals == 0)
+    {
+        return n;
+    }
+    n += formatText(buf + n, size - n, ".");
+
+    // Fraction with its leading zeros, 5 at 2 decimals is "05"
+    uint32_t fraction = magnitude % scale;
+    for (int i = decimals - 1; i >= 0; i--)
+    {
+        char digit[2] = {(char)('0' + (fraction / powersOfTen[i]) % 10), '\0'};
+        n += formatText(buf + n, size - n, digit);
+    }
+    return n;
+}
+
+int formatPercent(char *buf, int size, uint32_t value, uint32_t full, int decimals)
+{
+    decimals = constrain(decimals, 0, 6);
+    if (full == 0)
+    {
+        return formatFixed(buf, size, 0, decimals);
+    }
+    uint64_t scaled = ((uint64_t)value * 100 * powersOfTen[decimals] + full / 2) / full;
+    return formatFixed(buf, size, (int32_t)scaled, decimals);
+}
+
+// Unit chosen so there are three significant figures, rounded to the last one shown
+int formatDuration(char *buf, int size, uint32_t us)
+{
+    if (us < 1000)
+    {
+        int n = formatUInt(buf, size, us);
+        return n + formatText(buf + n, size - n, "us");
+    }
+
+    const char *unit = "ms";
+    uint32_t divisor = 1000; // us per unit
+    if (us >= 999500)
+    {
+        unit = "s";
+        divisor = 1000000;
+    }
+
+    // Decimals for three figures, the rounded value can carry into the next decade ("9.996ms" -> "10.00ms")
+    uint32_t whole = us / divisor;
+    int decimals = whole >= 100 ? 0 : (whole >= 10 ? 1 : 2);
+    uint32_t step = divisor / powersOfTen[decimals];
+    uint32_t value = ((uint64_t)us + step / 2) / step;
+
+    int n = formatFixed(buf, size, (int32_t)value, decimals);
+    return n + formatText(buf + n, size - n, unit);
+}